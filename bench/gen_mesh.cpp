@@ -0,0 +1,210 @@
+// SPDX-FileCopyrightText: 2025 (c) David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#include <cstdlib>
+#include "exo_writer.h"
+#include "cxxopts/cxxopts.hpp"
+#include <fmt/core.h>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/// Parameters of the generated mesh
+struct MeshSpec {
+    /// Spatial dimension (2 = QUAD4, 3 = HEX8)
+    int dim = 2;
+    /// Number of elements along each side of the unit square/cube
+    int n = 100;
+    /// Number of parts
+    int n_parts = 4;
+    /// Number of time steps
+    int n_steps = 10;
+    /// Number of nodal variables
+    int n_nodal_vars = 2;
+    /// Number of element variables
+    int n_elem_vars = 1;
+    /// Put elements with y > 0.5 into block 2 and define the last element variable only on block 1
+    bool two_blocks = false;
+};
+
+/// Value of nodal variable `v` at a point and time, the same in every part sharing the point
+inline double
+nodal_value(int v, double t, double x, double y, double z)
+{
+    return std::sin(x + v) * std::cos(y - t) + z * (v + 1) + t;
+}
+
+/// Write one part of the decomposed mesh
+///
+/// The unit square (cube) is cut into slabs along x, neighbouring slabs share the nodes on the
+/// plane between them. Part 0 has a node set (ID 1) on the x = 0 plane.
+/// The elements are in block 1, or split between blocks 1 and 2 with `spec.two_blocks`.
+///
+/// @param filename Output file name
+/// @param spec Mesh parameters
+/// @param part Part index
+void
+write_part(const std::string & filename, const MeshSpec & spec, int part)
+{
+    int n = spec.n;
+    int i0 = static_cast<int>(static_cast<int64_t>(n) * part / spec.n_parts);
+    int i1 = static_cast<int>(static_cast<int64_t>(n) * (part + 1) / spec.n_parts);
+    int nx = i1 - i0;
+    int nz = spec.dim == 3 ? n : 0;
+    double h = 1. / n;
+
+    // local node index of grid point (i, j, k), i relative to i0
+    auto node = [&](int i, int j, int k) {
+        return (static_cast<int64_t>(k) * (n + 1) + j) * (nx + 1) + i;
+    };
+    int64_t n_nodes = static_cast<int64_t>(nx + 1) * (n + 1) * (nz + 1);
+    int64_t n_elems = static_cast<int64_t>(nx) * n * std::max(nz, 1);
+
+    std::vector<double> x(n_nodes), y(n_nodes), z(n_nodes, 0.);
+    for (int k = 0; k <= nz; ++k)
+        for (int j = 0; j <= n; ++j)
+            for (int i = 0; i <= nx; ++i) {
+                auto a = node(i, j, k);
+                x[a] = (i0 + i) * h;
+                y[a] = j * h;
+                z[a] = k * h;
+            }
+
+    // block index -> connectivity (1-based) and element centroids
+    int n_blocks = spec.two_blocks ? 2 : 1;
+    std::vector<std::vector<int>> connect(n_blocks);
+    std::vector<std::vector<double>> xc(n_blocks), yc(n_blocks), zc(n_blocks);
+    for (int k = 0; k < std::max(nz, 1); ++k)
+        for (int j = 0; j < n; ++j)
+            for (int i = 0; i < nx; ++i) {
+                int kk = spec.dim == 3 ? k : 0;
+                std::vector<int64_t> vs = { node(i, j, kk),
+                                            node(i + 1, j, kk),
+                                            node(i + 1, j + 1, kk),
+                                            node(i, j + 1, kk) };
+                if (spec.dim == 3)
+                    for (int c = 0; c < 4; ++c)
+                        vs.push_back(vs[c] + static_cast<int64_t>(n + 1) * (nx + 1));
+                int b = spec.two_blocks && 2 * j >= n ? 1 : 0;
+                for (auto v : vs)
+                    connect[b].push_back(static_cast<int>(v + 1));
+                xc[b].push_back((i0 + i + 0.5) * h);
+                yc[b].push_back((j + 0.5) * h);
+                zc[b].push_back(spec.dim == 3 ? (k + 0.5) * h : 0.);
+            }
+
+    ExoWriter exo(filename, false);
+    int n_node_sets = part == 0 ? 1 : 0;
+    exo.init("", spec.dim, n_nodes, n_elems, n_blocks, n_node_sets, 0);
+    if (spec.dim == 3)
+        exo.write_coords(x, y, z);
+    else
+        exo.write_coords(x, y);
+    for (int b = 0; b < n_blocks; ++b)
+        exo.write_block(b + 1, spec.dim == 3 ? "HEX8" : "QUAD4", xc[b].size(), connect[b]);
+    if (part == 0) {
+        std::vector<int> ids;
+        for (int k = 0; k <= nz; ++k)
+            for (int j = 0; j <= n; ++j)
+                ids.push_back(static_cast<int>(node(0, j, k) + 1));
+        exo.write_node_set(1, ids);
+    }
+
+    std::vector<std::string> nodal_names, elem_names;
+    for (int v = 0; v < spec.n_nodal_vars; ++v)
+        nodal_names.push_back(fmt::format("u{}", v));
+    for (int v = 0; v < spec.n_elem_vars; ++v)
+        elem_names.push_back(fmt::format("e{}", v));
+    exo.write_nodal_var_names(nodal_names);
+    // block index -> element variable -> the variable is on the block
+    std::vector<int> truth(n_blocks * spec.n_elem_vars, 1);
+    if (spec.two_blocks && spec.n_elem_vars > 0)
+        truth.back() = 0;
+    if (!elem_names.empty()) {
+        exo.write_elem_var_names(elem_names);
+        exo.write_elem_truth_table(n_blocks, spec.n_elem_vars, truth);
+    }
+    exo.write_global_var_names({ "time" });
+
+    std::vector<double> vals;
+    for (int s = 1; s <= spec.n_steps; ++s) {
+        double t = 0.1 * (s - 1);
+        exo.write_time(s, t);
+        vals.resize(n_nodes);
+        for (int v = 0; v < spec.n_nodal_vars; ++v) {
+            for (int64_t a = 0; a < n_nodes; ++a)
+                vals[a] = nodal_value(v, t, x[a], y[a], z[a]);
+            exo.write_nodal_var(s, v + 1, vals);
+        }
+        for (int b = 0; b < n_blocks; ++b)
+            for (int v = 0; v < spec.n_elem_vars; ++v) {
+                if (!truth[b * spec.n_elem_vars + v])
+                    continue;
+                vals.resize(xc[b].size());
+                for (std::size_t e = 0; e < vals.size(); ++e)
+                    vals[e] = nodal_value(v, t, xc[b][e], yc[b][e], zc[b][e]);
+                exo.write_elem_var(s, v + 1, b + 1, vals);
+            }
+        exo.write_global_var(s, 1, t);
+    }
+}
+
+int
+main(int argc, char * argv[])
+{
+    cxxopts::Options options("exo-gen-mesh",
+                             "Generate a decomposed QUAD4/HEX8 mesh for benchmarking exo-join");
+
+    // clang-format off
+    options.add_options()
+        ("help", "Show this help page")
+        ("dim", "Spatial dimension [2, 3]", cxxopts::value<int>()->default_value("2"))
+        ("n", "Number of elements along each side", cxxopts::value<int>()->default_value("100"))
+        ("parts", "Number of parts", cxxopts::value<int>()->default_value("4"))
+        ("steps", "Number of time steps", cxxopts::value<int>()->default_value("10"))
+        ("nodal-vars", "Number of nodal variables", cxxopts::value<int>()->default_value("2"))
+        ("elem-vars", "Number of element variables", cxxopts::value<int>()->default_value("1"))
+        ("two-blocks", "Split elements into blocks 1 and 2 by y, the last element variable "
+            "only on block 1")
+        ("prefix", "Output file prefix, parts are written to <prefix>.<parts>.<part>",
+            cxxopts::value<std::string>()->default_value("mesh.e"))
+    ;
+    // clang-format on
+
+    try {
+        auto result = options.parse(argc, argv);
+        if (result.count("help")) {
+            fmt::print(stdout, "{}", options.help());
+            return 0;
+        }
+
+        MeshSpec spec;
+        spec.dim = result["dim"].as<int>();
+        spec.n = result["n"].as<int>();
+        spec.n_parts = result["parts"].as<int>();
+        spec.n_steps = result["steps"].as<int>();
+        spec.n_nodal_vars = result["nodal-vars"].as<int>();
+        spec.n_elem_vars = result["elem-vars"].as<int>();
+        spec.two_blocks = result.count("two-blocks") > 0;
+        if (spec.dim != 2 && spec.dim != 3)
+            throw std::runtime_error(fmt::format("Unsupported dimension {}", spec.dim));
+        if (spec.n_parts < 1 || spec.n < spec.n_parts)
+            throw std::runtime_error("Need at least one element along x per part");
+
+        auto prefix = result["prefix"].as<std::string>();
+        for (int p = 0; p < spec.n_parts; ++p)
+            write_part(fmt::format("{}.{}.{}", prefix, spec.n_parts, p), spec, p);
+        return 0;
+    }
+    catch (const cxxopts::exceptions::exception & e) {
+        fmt::print(stderr, "Error: {}\n", e.what());
+        fmt::print(stdout, "{}", options.help());
+        return 1;
+    }
+    catch (std::exception & e) {
+        fmt::print(stderr, "Error: {}\n", e.what());
+        return 1;
+    }
+}
@@ -0,0 +1,220 @@
+// SPDX-FileCopyrightText: 2025 (c) David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#include "kernels.h"
+#include "node_dedup.h"
+#include "node_sort.h"
+#include "progress.h"
+#include "reorder.h"
+#include "thread_pool.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr double TOLERANCE = 1e-10;
+
+/// Nodes of `n_parts` slabs of a 2D grid with `n` x `n` cells, shared nodes repeated once per
+/// slab that has them, like the coordinates exo-join reads from decomposed inputs
+struct GridNodes {
+    std::vector<double> x, y, z;
+
+    GridNodes(int n, int n_parts)
+    {
+        double h = 1. / n;
+        for (int p = 0; p < n_parts; ++p) {
+            int i0 = n * p / n_parts;
+            int i1 = n * (p + 1) / n_parts;
+            for (int j = 0; j <= n; ++j)
+                for (int i = i0; i <= i1; ++i) {
+                    this->x.push_back(i * h);
+                    this->y.push_back(j * h);
+                    this->z.push_back(0.);
+                }
+        }
+    }
+};
+
+/// Random permutation of `0..n-1`
+template <typename INT>
+std::vector<INT>
+permutation(std::size_t n)
+{
+    std::vector<INT> idx(n);
+    std::iota(idx.begin(), idx.end(), 0);
+    std::mt19937 rng(1234);
+    std::shuffle(idx.begin(), idx.end(), rng);
+    return idx;
+}
+
+} // namespace
+
+static void
+BM_NodeDedupInsert(benchmark::State & state)
+{
+    GridNodes pts(state.range(0), 8);
+    for (auto _ : state) {
+        NodeDedup<int> nodes(TOLERANCE);
+        nodes.reserve(pts.x.size());
+        for (std::size_t i = 0; i < pts.x.size(); ++i)
+            benchmark::DoNotOptimize(nodes.insert(pts.x[i], pts.y[i], pts.z[i]));
+    }
+    state.SetItemsProcessed(state.iterations() * pts.x.size());
+}
+BENCHMARK(BM_NodeDedupInsert)->Arg(256)->Arg(1024);
+
+/// Insert points that are all already present, like interface nodes of later inputs
+static void
+BM_NodeDedupMatch(benchmark::State & state)
+{
+    GridNodes pts(state.range(0), 8);
+    NodeDedup<int> nodes(TOLERANCE);
+    nodes.reserve(pts.x.size());
+    for (std::size_t i = 0; i < pts.x.size(); ++i)
+        nodes.insert(pts.x[i], pts.y[i], pts.z[i]);
+    for (auto _ : state)
+        for (std::size_t i = 0; i < pts.x.size(); ++i)
+            benchmark::DoNotOptimize(nodes.insert(pts.x[i], pts.y[i], pts.z[i]));
+    state.SetItemsProcessed(state.iterations() * pts.x.size());
+}
+BENCHMARK(BM_NodeDedupMatch)->Arg(256)->Arg(1024);
+
+static void
+BM_NodeDedupAppend(benchmark::State & state)
+{
+    GridNodes pts(state.range(0), 8);
+    for (auto _ : state) {
+        NodeDedup<int> nodes(TOLERANCE);
+        nodes.reserve(pts.x.size(), 0);
+        for (std::size_t i = 0; i < pts.x.size(); ++i)
+            benchmark::DoNotOptimize(nodes.append(pts.x[i], pts.y[i], pts.z[i]));
+    }
+    state.SetItemsProcessed(state.iterations() * pts.x.size());
+}
+BENCHMARK(BM_NodeDedupAppend)->Arg(256)->Arg(1024);
+
+static void
+BM_SortDedup(benchmark::State & state)
+{
+    GridNodes pts(state.range(0), 8);
+    ThreadPool pool(state.range(1));
+    for (auto _ : state) {
+        NodeDedup<int> nodes(TOLERANCE);
+        auto ids = sort_dedup(pool, pts.x, pts.y, pts.z, TOLERANCE, nodes);
+        benchmark::DoNotOptimize(ids.data());
+    }
+    state.SetItemsProcessed(state.iterations() * pts.x.size());
+}
+BENCHMARK(BM_SortDedup)->Args({ 1024, 1 })->Args({ 1024, 4 });
+
+template <typename INT>
+static void
+BM_RemapConnectivity(benchmark::State & state)
+{
+    std::size_t n_nodes = state.range(0);
+    auto is = permutation<INT>(n_nodes);
+    // QUAD4-like connectivity: every node referenced 4 times, in random order
+    std::vector<INT> connect;
+    for (int c = 0; c < 4; ++c)
+        for (auto i : permutation<INT>(n_nodes))
+            connect.push_back(i + 1);
+    std::vector<INT> work(connect.size());
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::copy(connect.begin(), connect.end(), work.begin());
+        state.ResumeTiming();
+        remap_connectivity(work, is);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * connect.size());
+}
+BENCHMARK(BM_RemapConnectivity<int>)->Arg(1 << 20);
+BENCHMARK(BM_RemapConnectivity<int64_t>)->Arg(1 << 20);
+
+static void
+BM_Scatter(benchmark::State & state)
+{
+    std::size_t n = state.range(0);
+    std::size_t n_vars = state.range(1);
+    auto idx = permutation<int>(n);
+    std::vector<std::vector<double>> src(n_vars, std::vector<double>(n, 1.));
+    std::vector<std::vector<double>> dest(n_vars, std::vector<double>(n));
+    for (auto _ : state) {
+        scatter(src, idx, dest);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * n * n_vars * 2 * sizeof(double));
+}
+BENCHMARK(BM_Scatter)->Args({ 1 << 20, 1 })->Args({ 1 << 20, 8 });
+
+static void
+BM_CopyIndexed(benchmark::State & state)
+{
+    std::size_t n = state.range(0);
+    std::size_t n_vars = state.range(1);
+    auto src_idx = permutation<int>(n);
+    std::vector<int> dest_idx(n);
+    std::iota(dest_idx.begin(), dest_idx.end(), 0);
+    std::vector<std::vector<double>> src(n_vars, std::vector<double>(n, 1.));
+    std::vector<std::vector<double>> dest(n_vars, std::vector<double>(n));
+    for (auto _ : state) {
+        copy_indexed(src, src_idx, dest_idx, dest);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * n * n_vars * 2 * sizeof(double));
+}
+BENCHMARK(BM_CopyIndexed)->Args({ 1 << 20, 1 })->Args({ 1 << 20, 8 });
+
+static void
+BM_GatherElements(benchmark::State & state)
+{
+    std::size_t n_elems = state.range(0);
+    constexpr int NN = ElementTraits<ElementType::HEX8>::N_NODES;
+    auto order = permutation<int>(n_elems);
+    std::vector<int> connect(n_elems * NN, 1);
+    std::vector<int> permuted(connect.size());
+    for (auto _ : state) {
+        gather_elements<NN>(connect.data(), order, permuted.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * n_elems);
+}
+BENCHMARK(BM_GatherElements)->Arg(1 << 18);
+
+static void
+BM_Moments(benchmark::State & state)
+{
+    std::size_t n = state.range(0);
+    std::vector<double> vals(n);
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<double> dist(-1., 1.);
+    for (auto & v : vals)
+        v = dist(rng);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(moments(vals.data(), vals.size()));
+    state.SetBytesProcessed(state.iterations() * n * sizeof(double));
+}
+BENCHMARK(BM_Moments)->Arg(1 << 20);
+
+/// Cost of accounting progress, disabled (0) or reported to /dev/null (1)
+static void
+BM_ProgressAdvance(benchmark::State & state)
+{
+    static Progress prog;
+    static std::FILE * null = std::fopen("/dev/null", "w");
+    if (state.thread_index() == 0 && state.range(0)) {
+        prog.enable(ProgressFormat::JSON, 0.1, null);
+        prog.phase("bench", 1 << 30, "items");
+    }
+    for (auto _ : state)
+        prog.advance(1, 8);
+    if (state.thread_index() == 0)
+        prog.finish();
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ProgressAdvance)->Arg(0)->Arg(1)->Threads(1)->Threads(4);
+
+BENCHMARK_MAIN();
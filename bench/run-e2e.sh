@@ -0,0 +1,86 @@
+#!/bin/sh
+# SPDX-FileCopyrightText: 2025 (c) David Andrs <andrsd@gmail.com>
+# SPDX-License-Identifier: MIT
+#
+# End-to-end timings of exo-join, exo-info and exo-split on generated decomposed meshes
+#
+# Usage: run-e2e.sh <exo-gen-mesh> <exo-join> <exo-info> <exo-split> <work-dir> <results.json>
+#
+# The first four arguments are the paths of the tools. Each case is recorded with the JSON
+# profile (--profile=json) of the run.
+
+set -e
+
+gen_mesh=$1
+exo_join=$2
+exo_info=$3
+exo_split=$4
+work_dir=$5
+results=$6
+if [ -z "$gen_mesh" ] || [ -z "$exo_join" ] || [ -z "$exo_info" ] || [ -z "$exo_split" ] ||
+    [ -z "$work_dir" ] || [ -z "$results" ]; then
+    echo "Usage: $0 <exo-gen-mesh> <exo-join> <exo-info> <exo-split> <work-dir> <results.json>" >&2
+    exit 1
+fi
+
+mkdir -p "$work_dir"
+
+# name dim n parts steps nodal-vars elem-vars blocks
+#
+# With 2 blocks, the last element variable only exists on block 1.
+cases="
+quad-16 2 1024 16 10 4 1 1
+quad-128 2 2048 128 5 2 1 1
+hex-16 3 96 16 10 4 1 1
+quad-blocks-16 2 512 16 5 2 2 2
+"
+
+first=1
+echo "[" > "$results"
+echo "$cases" | while read -r name dim n parts steps nvars evars blocks; do
+    [ -z "$name" ] && continue
+    prefix="$work_dir/$name.e"
+    two_blocks=""
+    if [ "$blocks" -eq 2 ]; then
+        two_blocks="--two-blocks"
+    fi
+    "$gen_mesh" --dim "$dim" --n "$n" --parts "$parts" --steps "$steps" \
+        --nodal-vars "$nvars" --elem-vars "$evars" $two_blocks --prefix "$prefix"
+
+    for run in join join-sort join-external info info-stats split; do
+        case $run in
+        join)
+            cmd="$exo_join --jobs 4 --profile=json $prefix.$parts.* \
+                $work_dir/$name.joined.e"
+            ;;
+        join-sort)
+            cmd="$exo_join --jobs 4 --dedup sort --profile=json $prefix.$parts.* \
+                $work_dir/$name.joined.e"
+            ;;
+        join-external)
+            cmd="$exo_join --jobs 4 --dedup external --mem-limit 16M --profile=json \
+                $prefix.$parts.* $work_dir/$name.joined.e"
+            ;;
+        info)
+            cmd="$exo_info --jobs 4 --profile=json $prefix.$parts.*"
+            ;;
+        info-stats)
+            # the joined file was just rewritten, so the statistics cache is stale
+            cmd="$exo_info --jobs 4 --stats --profile=json $work_dir/$name.joined.e"
+            ;;
+        split)
+            cmd="$exo_split --jobs 4 --parts $parts --profile=json \
+                -o $work_dir/$name.split.e $work_dir/$name.joined.e"
+            ;;
+        esac
+        profile=$($cmd 2>&1 >/dev/null | tail -n 1)
+        if [ $first -eq 0 ]; then
+            echo "," >> "$results"
+        fi
+        first=0
+        printf '{"case": "%s", "run": "%s", "profile": %s}' "$name" "$run" "$profile" \
+            >> "$results"
+        echo "$name $run done" >&2
+    done
+done
+echo "]" >> "$results"
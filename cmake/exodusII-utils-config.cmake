@@ -1,6 +1,13 @@
 set(_pkg exodusII-utils)
 set(_pkg_prefix exodusII_utils)
 
+# exodusII-utils::core, the header-only library the tools are built on
+include(CMakeFindDependencyMacro)
+find_dependency(exodusIIcpp 3)
+find_dependency(fmt 11)
+find_dependency(Threads)
+include("${CMAKE_CURRENT_LIST_DIR}/exodusII-utils-targets.cmake")
+
 # Mirror CMake’s internal variables (replace '-' with '_')
 # so we can safely use them in code.
 set(${_pkg_prefix}_FIND_COMPONENTS ${${_pkg}_FIND_COMPONENTS})
@@ -9,13 +16,18 @@ foreach(_comp IN LISTS ${_pkg_prefix}_FIND_COMPONENTS)
 endforeach()
 
 # Define known components
-set(_${_pkg_prefix}_known_components exo-info exo-join)
+set(_${_pkg_prefix}_known_components core exo-info exo-join exo-split)
 
 foreach(_comp IN LISTS exodusII_utils_FIND_COMPONENTS)
     if (NOT _comp IN_LIST _exodusII_utils_known_components)
         message(FATAL_ERROR "Unknown component '${_comp}' requested from exodusII-utils")
     endif()
 
+    # the library comes with the exported targets
+    if (_comp STREQUAL "core")
+        continue()
+    endif()
+
     # Find corresponding executable
     find_program(exodusII_utils_${_comp}_EXECUTABLE
         NAMES ${_comp}
@@ -0,0 +1,115 @@
+// SPDX-FileCopyrightText: 2025 (c) David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <unistd.h>
+#include <fmt/core.h>
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace detail {
+
+/// Tag at the start of a binary file, telling its kind and format version
+using FileMagic = char[8];
+
+/// Write a trivially copyable value in the native byte order
+template <typename T>
+inline void
+write_pod(std::ofstream & os, const T & val)
+{
+    os.write(reinterpret_cast<const char *>(&val), sizeof(T));
+}
+
+template <typename T>
+inline T
+read_pod(std::ifstream & is)
+{
+    T val;
+    is.read(reinterpret_cast<char *>(&val), sizeof(T));
+    if (!is)
+        throw std::runtime_error("Truncated file");
+    return val;
+}
+
+/// Write the size of `vals`, then its elements
+template <typename T>
+inline void
+write_array(std::ofstream & os, const std::vector<T> & vals)
+{
+    write_pod<uint64_t>(os, vals.size());
+    os.write(reinterpret_cast<const char *>(vals.data()), vals.size() * sizeof(T));
+}
+
+template <typename T>
+inline std::vector<T>
+read_array(std::ifstream & is)
+{
+    std::vector<T> vals(read_pod<uint64_t>(is));
+    is.read(reinterpret_cast<char *>(vals.data()), vals.size() * sizeof(T));
+    if (!is)
+        throw std::runtime_error("Truncated file");
+    return vals;
+}
+
+inline void
+write_magic(std::ofstream & os, const FileMagic & magic)
+{
+    os.write(magic, sizeof(FileMagic));
+}
+
+/// @return `true` if the stream starts with `magic`
+inline bool
+read_magic(std::ifstream & is, const FileMagic & magic)
+{
+    char buf[sizeof(FileMagic)];
+    is.read(buf, sizeof(buf));
+    return is && std::equal(buf, buf + sizeof(buf), magic);
+}
+
+/// Replace a file with the contents written by `fn(os)`
+///
+/// The contents go to a temporary file next to it, which is then renamed over `filename`. The
+/// file is thus replaced atomically, so concurrent readers never see it partially written.
+///
+/// @param filename File name
+/// @param fn Callable `void(std::ofstream &)` writing the contents
+/// @return `false` if the file could not be written (e.g. read-only directory)
+template <typename FN>
+inline bool
+replace_file(const std::string & filename, FN && fn)
+{
+    auto tmp = fmt::format("{}.{}.tmp", filename, getpid());
+    std::error_code ec;
+    {
+        std::ofstream os(tmp, std::ios::binary | std::ios::trunc);
+        if (!os)
+            return false;
+        try {
+            fn(os);
+        }
+        catch (...) {
+            os.close();
+            std::filesystem::remove(tmp, ec);
+            throw;
+        }
+        os.close();
+        if (!os) {
+            std::filesystem::remove(tmp, ec);
+            return false;
+        }
+    }
+    std::filesystem::rename(tmp, filename, ec);
+    if (ec) {
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+    return true;
+}
+
+} // namespace detail
@@ -5,6 +5,8 @@
 
 #include <fmt/core.h>
 #include <string>
+#include <string_view>
+#include <stdexcept>
 #include <algorithm>
 
 enum class ElementType {
@@ -29,12 +31,14 @@ element_type(std::string_view str)
         return ElementType::TRI3;
     else if (str == "QUAD" || str == "QUAD4")
         return ElementType::QUAD4;
-    else if (str == "TETRA" || str == "TET4")
+    else if (str == "TETRA" || str == "TETRA4" || str == "TET4")
         return ElementType::TET4;
     else if (str == "HEX" || str == "HEX8")
         return ElementType::HEX8;
-    else if (str == "WEDGE")
+    else if (str == "WEDGE" || str == "WEDGE6")
         return ElementType::PRISM6;
+    else if (str == "PYRAMID" || str == "PYRAMID5")
+        return ElementType::PYRAMID5;
     else
         throw std::runtime_error(fmt::format("Unsupported element type {}", str));
 }
@@ -0,0 +1,125 @@
+// SPDX-FileCopyrightText: 2025 (c) David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "common.h"
+#include <fmt/core.h>
+#include <stdexcept>
+
+/// Compile-time properties of an element type
+///
+/// @tparam ET Element type
+template <ElementType ET>
+struct ElementTraits;
+
+template <>
+struct ElementTraits<ElementType::POINT1> {
+    /// Element type name written to exodusII files
+    static constexpr const char * NAME = "SPHERE";
+    static constexpr int N_NODES = 1;
+    /// Number of sides side sets can refer to
+    static constexpr int N_SIDES = 0;
+};
+
+template <>
+struct ElementTraits<ElementType::SEGMENT2> {
+    static constexpr const char * NAME = "BAR2";
+    static constexpr int N_NODES = 2;
+    static constexpr int N_SIDES = 2;
+};
+
+template <>
+struct ElementTraits<ElementType::TRI3> {
+    static constexpr const char * NAME = "TRI3";
+    static constexpr int N_NODES = 3;
+    static constexpr int N_SIDES = 3;
+};
+
+template <>
+struct ElementTraits<ElementType::QUAD4> {
+    static constexpr const char * NAME = "QUAD4";
+    static constexpr int N_NODES = 4;
+    static constexpr int N_SIDES = 4;
+};
+
+template <>
+struct ElementTraits<ElementType::TET4> {
+    static constexpr const char * NAME = "TET4";
+    static constexpr int N_NODES = 4;
+    static constexpr int N_SIDES = 4;
+};
+
+template <>
+struct ElementTraits<ElementType::HEX8> {
+    static constexpr const char * NAME = "HEX8";
+    static constexpr int N_NODES = 8;
+    static constexpr int N_SIDES = 6;
+};
+
+template <>
+struct ElementTraits<ElementType::PRISM6> {
+    static constexpr const char * NAME = "WEDGE6";
+    static constexpr int N_NODES = 6;
+    static constexpr int N_SIDES = 5;
+};
+
+template <>
+struct ElementTraits<ElementType::PYRAMID5> {
+    static constexpr const char * NAME = "PYRAMID5";
+    static constexpr int N_NODES = 5;
+    static constexpr int N_SIDES = 5;
+};
+
+/// Call `fn` with the traits of an element type
+///
+/// Used to pick a kernel specialized for the element type once per block, e.g.
+/// `dispatch(et, [&](auto traits) { kernel<decltype(traits)::N_NODES>(...); })`.
+///
+/// @param et Element type
+/// @param fn Callable taking `ElementTraits<ET>`
+template <typename FN>
+inline decltype(auto)
+dispatch(ElementType et, FN && fn)
+{
+    switch (et) {
+    case ElementType::POINT1:
+        return fn(ElementTraits<ElementType::POINT1>());
+    case ElementType::SEGMENT2:
+        return fn(ElementTraits<ElementType::SEGMENT2>());
+    case ElementType::TRI3:
+        return fn(ElementTraits<ElementType::TRI3>());
+    case ElementType::QUAD4:
+        return fn(ElementTraits<ElementType::QUAD4>());
+    case ElementType::TET4:
+        return fn(ElementTraits<ElementType::TET4>());
+    case ElementType::HEX8:
+        return fn(ElementTraits<ElementType::HEX8>());
+    case ElementType::PRISM6:
+        return fn(ElementTraits<ElementType::PRISM6>());
+    case ElementType::PYRAMID5:
+        return fn(ElementTraits<ElementType::PYRAMID5>());
+    }
+    throw std::runtime_error("Unsupported element type");
+}
+
+/// Number of nodes of an element type
+inline int
+num_nodes(ElementType et)
+{
+    return dispatch(et, [](auto traits) { return decltype(traits)::N_NODES; });
+}
+
+/// Number of sides of an element type
+inline int
+num_sides(ElementType et)
+{
+    return dispatch(et, [](auto traits) { return decltype(traits)::N_SIDES; });
+}
+
+/// Name of an element type as written to exodusII files
+inline const char *
+exodus_element_name(ElementType et)
+{
+    return dispatch(et, [](auto traits) { return decltype(traits)::NAME; });
+}
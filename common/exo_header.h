@@ -0,0 +1,256 @@
+// SPDX-FileCopyrightText: 2025 (c) David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "io_lock.h"
+#include "thread_pool.h"
+#include <exodusII.h>
+#include <fmt/core.h>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+/// Element block metadata
+struct BlockHeader {
+    int64_t id;
+    std::string name;
+    std::string element_type;
+    int64_t n_elems;
+    int64_t n_nodes_per_elem;
+};
+
+/// Node set / side set metadata
+struct SetHeader {
+    int64_t id;
+    std::string name;
+    /// Number of entries (nodes or sides)
+    int64_t size;
+};
+
+/// Everything exodusII stores in the file header, i.e. what can be read without touching the bulk
+/// data (coordinates, connectivity, sets, variable values)
+struct ExoHeader {
+    std::string title;
+    int dim;
+    int64_t n_nodes;
+    int64_t n_elems;
+    std::vector<BlockHeader> blocks;
+    std::vector<SetHeader> node_sets;
+    std::vector<SetHeader> side_sets;
+    std::vector<std::string> nodal_var_names;
+    std::vector<std::string> elem_var_names;
+    std::vector<std::string> global_var_names;
+    int n_times;
+    /// Bulk data is stored as 64-bit integers
+    bool int64;
+};
+
+namespace detail {
+
+/// Throw if an exodusII call failed
+inline void
+check_ex(int err, const char * what)
+{
+    if (err < 0)
+        throw std::runtime_error(fmt::format("exodusII: {} failed with error {}", what, err));
+}
+
+/// Closes an exodusII file when going out of scope
+struct ExoHandle {
+    int exoid;
+
+    explicit ExoHandle(const std::string & filename) : exoid(-1)
+    {
+        int cpu_ws = sizeof(double);
+        int io_ws = 0;
+        float version;
+        this->exoid = ex_open(filename.c_str(), EX_READ, &cpu_ws, &io_ws, &version);
+        if (this->exoid < 0)
+            throw std::runtime_error(fmt::format("Could not open file '{}'", filename));
+    }
+
+    ~ExoHandle()
+    {
+        if (this->exoid >= 0)
+            ex_close(this->exoid);
+    }
+
+    ExoHandle(const ExoHandle &) = delete;
+    ExoHandle & operator=(const ExoHandle &) = delete;
+};
+
+inline std::vector<SetHeader>
+read_set_headers(int exoid, ex_entity_type type, int64_t n, int name_len)
+{
+    std::vector<int64_t> ids(n);
+    if (n > 0)
+        check_ex(ex_get_ids(exoid, type, ids.data()), "ex_get_ids");
+    std::vector<SetHeader> sets;
+    std::vector<char> name(name_len + 1, '\0');
+    for (auto id : ids) {
+        int64_t n_entries = 0;
+        int64_t n_dist_factors = 0;
+        check_ex(ex_get_set_param(exoid, type, id, &n_entries, &n_dist_factors),
+                 "ex_get_set_param");
+        check_ex(ex_get_name(exoid, type, id, name.data()), "ex_get_name");
+        sets.push_back({ id, name.data(), n_entries });
+    }
+    return sets;
+}
+
+inline std::vector<std::string>
+read_variable_names(int exoid, ex_entity_type type, int name_len)
+{
+    int n_vars = 0;
+    check_ex(ex_get_variable_param(exoid, type, &n_vars), "ex_get_variable_param");
+    std::vector<std::string> names;
+    std::vector<char> name(name_len + 1, '\0');
+    for (int i = 1; i <= n_vars; ++i) {
+        check_ex(ex_get_variable_name(exoid, type, i, name.data()), "ex_get_variable_name");
+        names.emplace_back(name.data());
+    }
+    return names;
+}
+
+} // namespace detail
+
+/// Read file header without reading any bulk data
+///
+/// @param filename ExodusII file name
+/// @return File metadata
+inline ExoHeader
+read_header(const std::string & filename)
+{
+    detail::ExoHandle exo(filename);
+    auto exoid = exo.exoid;
+    ExoHeader hdr;
+
+    hdr.int64 = (ex_int64_status(exoid) & EX_BULK_INT64_DB) != 0;
+    // all integer arguments below are int64_t regardless of what the file stores
+    ex_set_int64_status(exoid, EX_ALL_INT64_API);
+    int name_len = static_cast<int>(ex_inquire_int(exoid, EX_INQ_DB_MAX_USED_NAME_LENGTH));
+    name_len = std::max(name_len, MAX_STR_LENGTH);
+    ex_set_max_name_length(exoid, name_len);
+
+    ex_init_params params;
+    detail::check_ex(ex_get_init_ext(exoid, &params), "ex_get_init_ext");
+    hdr.title = params.title;
+    hdr.dim = static_cast<int>(params.num_dim);
+    hdr.n_nodes = params.num_nodes;
+    hdr.n_elems = params.num_elem;
+
+    std::vector<int64_t> blk_ids(params.num_elem_blk);
+    if (params.num_elem_blk > 0)
+        detail::check_ex(ex_get_ids(exoid, EX_ELEM_BLOCK, blk_ids.data()), "ex_get_ids");
+    std::vector<char> name(name_len + 1, '\0');
+    char elem_type[MAX_STR_LENGTH + 1];
+    for (auto id : blk_ids) {
+        int64_t n_elems = 0, n_nodes_per_elem = 0, n_edges = 0, n_faces = 0, n_attrs = 0;
+        detail::check_ex(ex_get_block(exoid,
+                                      EX_ELEM_BLOCK,
+                                      id,
+                                      elem_type,
+                                      &n_elems,
+                                      &n_nodes_per_elem,
+                                      &n_edges,
+                                      &n_faces,
+                                      &n_attrs),
+                         "ex_get_block");
+        detail::check_ex(ex_get_name(exoid, EX_ELEM_BLOCK, id, name.data()), "ex_get_name");
+        hdr.blocks.push_back({ id, name.data(), elem_type, n_elems, n_nodes_per_elem });
+    }
+
+    hdr.node_sets = detail::read_set_headers(exoid, EX_NODE_SET, params.num_node_sets, name_len);
+    hdr.side_sets = detail::read_set_headers(exoid, EX_SIDE_SET, params.num_side_sets, name_len);
+
+    hdr.nodal_var_names = detail::read_variable_names(exoid, EX_NODAL, name_len);
+    hdr.elem_var_names = detail::read_variable_names(exoid, EX_ELEM_BLOCK, name_len);
+    hdr.global_var_names = detail::read_variable_names(exoid, EX_GLOBAL, name_len);
+
+    hdr.n_times = static_cast<int>(ex_inquire_int(exoid, EX_INQ_TIME));
+
+    return hdr;
+}
+
+/// Read headers of many files on the threads of a pool
+///
+/// @param pool Thread pool
+/// @param filenames ExodusII file names
+/// @return File metadata, in the order of `filenames`
+inline std::vector<ExoHeader>
+read_headers(ThreadPool & pool, const std::vector<std::string> & filenames)
+{
+    std::vector<ExoHeader> headers(filenames.size());
+    for_each_ordered(
+        pool,
+        filenames.size(),
+        pool.size(),
+        [&](std::size_t i) {
+            auto lock = lock_io();
+            return read_header(filenames[i]);
+        },
+        [&](std::size_t i, ExoHeader && hdr) { headers[i] = std::move(hdr); });
+    return headers;
+}
+
+/// Read the element variable truth table of a file
+///
+/// @param exoid ExodusII file ID
+/// @param hdr Header of the file
+/// @return `truth[b * n_elem_vars + v]` is non-zero if element variable `v` (0-based) exists on
+///         block `b` (0-based)
+inline std::vector<int>
+read_truth_table(int exoid, const ExoHeader & hdr)
+{
+    auto n_blocks = hdr.blocks.size();
+    auto n_elem_vars = hdr.elem_var_names.size();
+    std::vector<int> truth(n_blocks * n_elem_vars, 1);
+    if (!truth.empty())
+        detail::check_ex(ex_get_truth_table(exoid,
+                                            EX_ELEM_BLOCK,
+                                            static_cast<int>(n_blocks),
+                                            static_cast<int>(n_elem_vars),
+                                            truth.data()),
+                         "ex_get_truth_table");
+    return truth;
+}
+
+/// Finds the block of an element given by its file-wide index
+///
+/// Side sets refer to elements by their position in the file, i.e. counting through the blocks in
+/// the order they are stored.
+class ElementLocator {
+public:
+    explicit ElementLocator(const ExoHeader & hdr) : n_elems(0)
+    {
+        for (auto & blk : hdr.blocks) {
+            this->ranges.emplace_back(this->n_elems, blk.id);
+            this->n_elems += blk.n_elems;
+        }
+    }
+
+    /// @param e File-wide element index (0-based)
+    /// @return Block ID and the index of the element within the block
+    std::pair<int64_t, int64_t>
+    locate(int64_t e) const
+    {
+        auto it = std::upper_bound(this->ranges.begin(),
+                                   this->ranges.end(),
+                                   std::make_pair(e, std::numeric_limits<int64_t>::max()));
+        if (e < 0 || e >= this->n_elems || it == this->ranges.begin())
+            throw std::runtime_error(fmt::format("Element {} is not in any block", e + 1));
+        --it;
+        return { it->second, e - it->first };
+    }
+
+private:
+    /// First element of every block and the block's ID
+    std::vector<std::pair<int64_t, int64_t>> ranges;
+    /// Number of elements in all blocks
+    int64_t n_elems;
+};
@@ -0,0 +1,554 @@
+// SPDX-FileCopyrightText: 2025 (c) David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "exo_header.h"
+#include <exodusII.h>
+#ifdef EXODUSII_UTILS_MPI
+    #include <exodusII_par.h>
+#endif
+#include <fmt/core.h>
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// Output compression
+enum class Compression {
+    //
+    NONE,
+    ZLIB,
+    ZSTD
+};
+
+/// Convert string representation of a compression method into enum
+inline Compression
+compression_method(std::string_view str)
+{
+    if (str == "none")
+        return Compression::NONE;
+    else if (str == "zlib")
+        return Compression::ZLIB;
+    else if (str == "zstd")
+        return Compression::ZSTD;
+    else
+        throw std::runtime_error(fmt::format("Unsupported compression method {}", str));
+}
+
+/// Writes an exodusII file through the C API
+///
+/// The file stores bulk data (connectivity, sets) as 64-bit integers when created with `int64`,
+/// in which case all integer arrays handed to the writer must be `int64_t`, otherwise `int`.
+///
+/// Compressed files are netCDF-4 (HDF5) files. exodusII stores every nodal and element variable
+/// as its own record variable, chunked by time step, so reading one step of one variable only
+/// decompresses that step of that variable.
+class ExoWriter {
+public:
+    /// Create (or overwrite) a file
+    ///
+    /// @param filename File name
+    /// @param int64 Store bulk data as 64-bit integers
+    /// @param compression Compression method
+    /// @param level Compression level (1-9 for zlib, 1-22 for zstd)
+    ExoWriter(const std::string & filename,
+              bool int64,
+              Compression compression = Compression::NONE,
+              int level = 1) :
+        exoid(-1),
+        int64(int64)
+    {
+        int max_level = compression == Compression::ZSTD ? 22 : 9;
+        if (compression != Compression::NONE && (level < 1 || level > max_level))
+            throw std::runtime_error(
+                fmt::format("Compression level must be between 1 and {}", max_level));
+
+        int cpu_ws = sizeof(double);
+        int io_ws = sizeof(double);
+        int mode = EX_CLOBBER;
+        if (int64)
+            mode |= EX_ALL_INT64_DB | EX_ALL_INT64_API;
+        if (compression != Compression::NONE)
+            mode |= EX_NETCDF4;
+        this->exoid = ex_create(filename.c_str(), mode, &cpu_ws, &io_ws);
+        if (this->exoid < 0)
+            throw std::runtime_error(fmt::format("Could not create file '{}'", filename));
+
+        if (compression != Compression::NONE) {
+            auto type = compression == Compression::ZSTD ? EX_COMPRESS_ZSTD : EX_COMPRESS_ZLIB;
+            // options apply to variables defined from now on, i.e. to all of them
+            detail::check_ex(ex_set_option(this->exoid, EX_OPT_COMPRESSION_TYPE, type),
+                             "ex_set_option");
+            detail::check_ex(ex_set_option(this->exoid, EX_OPT_COMPRESSION_LEVEL, level),
+                             "ex_set_option");
+            // byte shuffling makes floating point data compress much better
+            detail::check_ex(ex_set_option(this->exoid, EX_OPT_COMPRESSION_SHUFFLE, 1),
+                             "ex_set_option");
+        }
+    }
+
+#ifdef EXODUSII_UTILS_MPI
+    /// Create (or overwrite) a file written by all ranks of `comm`
+    ///
+    /// The file is a netCDF-4 (HDF5) file written through MPI-IO. All ranks must call the same
+    /// methods in the same order with the same arguments, except for the `write_partial_*`
+    /// methods, where each rank passes its own slice of the data (possibly empty).
+    ///
+    /// @param comm Communicator
+    /// @param filename File name
+    /// @param int64 Store bulk data as 64-bit integers
+    ExoWriter(MPI_Comm comm, const std::string & filename, bool int64) : exoid(-1), int64(int64)
+    {
+        int cpu_ws = sizeof(double);
+        int io_ws = sizeof(double);
+        int mode = EX_CLOBBER | EX_NETCDF4;
+        if (int64)
+            mode |= EX_ALL_INT64_DB | EX_ALL_INT64_API;
+        this->exoid =
+            ex_create_par(filename.c_str(), mode, &cpu_ws, &io_ws, comm, MPI_INFO_NULL);
+        if (this->exoid < 0)
+            throw std::runtime_error(fmt::format("Could not create file '{}'", filename));
+    }
+#endif
+
+    /// Open an existing file to append time steps to it
+    ///
+    /// @param filename File name
+    static ExoWriter
+    append(const std::string & filename)
+    {
+        int cpu_ws = sizeof(double);
+        int io_ws = 0;
+        float version;
+        int exoid = ex_open(filename.c_str(), EX_WRITE, &cpu_ws, &io_ws, &version);
+        if (exoid < 0)
+            throw std::runtime_error(fmt::format("Could not open file '{}'", filename));
+        bool int64 = (ex_int64_status(exoid) & EX_BULK_INT64_DB) != 0;
+        if (int64)
+            ex_set_int64_status(exoid, EX_ALL_INT64_API);
+        return ExoWriter(exoid, int64);
+    }
+
+    ~ExoWriter()
+    {
+        if (this->exoid >= 0)
+            ex_close(this->exoid);
+    }
+
+    ExoWriter(const ExoWriter &) = delete;
+    ExoWriter & operator=(const ExoWriter &) = delete;
+
+    void
+    init(const char * title,
+         int dim,
+         int64_t n_nodes,
+         int64_t n_elems,
+         int64_t n_elem_blks,
+         int64_t n_node_sets,
+         int64_t n_side_sets)
+    {
+        detail::check_ex(
+            ex_put_init(
+                this->exoid, title, dim, n_nodes, n_elems, n_elem_blks, n_node_sets, n_side_sets),
+            "ex_put_init");
+    }
+
+    void
+    write_coords(const std::vector<double> & x, const std::vector<double> & y)
+    {
+        detail::check_ex(ex_put_coord(this->exoid, x.data(), y.data(), nullptr), "ex_put_coord");
+        write_coord_names();
+    }
+
+    void
+    write_coords(const std::vector<double> & x,
+                 const std::vector<double> & y,
+                 const std::vector<double> & z)
+    {
+        detail::check_ex(ex_put_coord(this->exoid, x.data(), y.data(), z.data()), "ex_put_coord");
+        write_coord_names();
+    }
+
+    /// @param blk_id Block ID
+    /// @param elem_type Element type name
+    /// @param n_elems Number of elements
+    /// @param connect Connectivity (1-based)
+    template <typename INT>
+    void
+    write_block(int64_t blk_id,
+                const char * elem_type,
+                int64_t n_elems,
+                const std::vector<INT> & connect)
+    {
+        check_int<INT>();
+        int64_t nn = n_elems > 0 ? static_cast<int64_t>(connect.size()) / n_elems : 0;
+        detail::check_ex(
+            ex_put_block(this->exoid, EX_ELEM_BLOCK, blk_id, elem_type, n_elems, nn, 0, 0, 0),
+            "ex_put_block");
+        detail::check_ex(
+            ex_put_conn(this->exoid, EX_ELEM_BLOCK, blk_id, connect.data(), nullptr, nullptr),
+            "ex_put_conn");
+    }
+
+    /// @param id Node set ID
+    /// @param node_ids Node IDs (1-based)
+    template <typename INT>
+    void
+    write_node_set(int64_t id, const std::vector<INT> & node_ids)
+    {
+        check_int<INT>();
+        detail::check_ex(ex_put_set_param(this->exoid, EX_NODE_SET, id, node_ids.size(), 0),
+                         "ex_put_set_param");
+        detail::check_ex(ex_put_set(this->exoid, EX_NODE_SET, id, node_ids.data(), nullptr),
+                         "ex_put_set");
+    }
+
+    /// @param id Side set ID
+    /// @param elem_ids Element IDs (1-based)
+    /// @param side_ids Side IDs (1-based)
+    template <typename INT>
+    void
+    write_side_set(int64_t id, const std::vector<INT> & elem_ids, const std::vector<INT> & side_ids)
+    {
+        check_int<INT>();
+        assert(elem_ids.size() == side_ids.size());
+        detail::check_ex(ex_put_set_param(this->exoid, EX_SIDE_SET, id, elem_ids.size(), 0),
+                         "ex_put_set_param");
+        detail::check_ex(
+            ex_put_set(this->exoid, EX_SIDE_SET, id, elem_ids.data(), side_ids.data()),
+            "ex_put_set");
+    }
+
+    /// @param ids ID (1-based) of every node
+    template <typename INT>
+    void
+    write_node_id_map(const std::vector<INT> & ids)
+    {
+        check_int<INT>();
+        detail::check_ex(ex_put_id_map(this->exoid, EX_NODE_MAP, ids.data()), "ex_put_id_map");
+    }
+
+    /// @param ids ID (1-based) of every element, in file order
+    template <typename INT>
+    void
+    write_elem_id_map(const std::vector<INT> & ids)
+    {
+        check_int<INT>();
+        detail::check_ex(ex_put_id_map(this->exoid, EX_ELEM_MAP, ids.data()), "ex_put_id_map");
+    }
+
+    /// Declare which element variables exist on which blocks
+    ///
+    /// Must follow `write_elem_var_names()` and precede writing any element variable.
+    ///
+    /// @param n_blocks Number of element blocks
+    /// @param n_vars Number of element variables
+    /// @param table `table[b * n_vars + v]` is non-zero if variable `v` exists on block `b`
+    void
+    write_elem_truth_table(int n_blocks, int n_vars, const std::vector<int> & table)
+    {
+        assert(table.size() == static_cast<std::size_t>(n_blocks) * n_vars);
+        auto * data = const_cast<int *>(table.data());
+        detail::check_ex(ex_put_truth_table(this->exoid, EX_ELEM_BLOCK, n_blocks, n_vars, data),
+                         "ex_put_truth_table");
+    }
+
+    void
+    write_nodal_var_names(const std::vector<std::string> & names)
+    {
+        write_var_names(EX_NODAL, names);
+    }
+
+    void
+    write_elem_var_names(const std::vector<std::string> & names)
+    {
+        write_var_names(EX_ELEM_BLOCK, names);
+    }
+
+    void
+    write_global_var_names(const std::vector<std::string> & names)
+    {
+        write_var_names(EX_GLOBAL, names);
+    }
+
+    void
+    write_time(int step, double time)
+    {
+        detail::check_ex(ex_put_time(this->exoid, step, &time), "ex_put_time");
+    }
+
+    void
+    write_nodal_var(int step, int var_idx, const std::vector<double> & values)
+    {
+        detail::check_ex(
+            ex_put_var(this->exoid, step, EX_NODAL, var_idx, 1, values.size(), values.data()),
+            "ex_put_var");
+    }
+
+    void
+    write_elem_var(int step, int var_idx, int64_t blk_id, const std::vector<double> & values)
+    {
+        detail::check_ex(ex_put_var(this->exoid,
+                                    step,
+                                    EX_ELEM_BLOCK,
+                                    var_idx,
+                                    blk_id,
+                                    values.size(),
+                                    values.data()),
+                         "ex_put_var");
+    }
+
+    void
+    write_global_var(int step, int var_idx, double value)
+    {
+        detail::check_ex(ex_put_var(this->exoid, step, EX_GLOBAL, var_idx, 1, 1, &value),
+                         "ex_put_var");
+    }
+
+#ifdef EXODUSII_UTILS_MPI
+    /// Write coordinates of nodes `start` through `start + x.size() - 1`
+    ///
+    /// @param start First node (1-based)
+    void
+    write_partial_coords(int64_t start,
+                         const std::vector<double> & x,
+                         const std::vector<double> & y,
+                         const std::vector<double> * z = nullptr)
+    {
+        detail::check_ex(ex_put_partial_coord(this->exoid,
+                                              start,
+                                              x.size(),
+                                              x.data(),
+                                              y.data(),
+                                              z ? z->data() : nullptr),
+                         "ex_put_partial_coord");
+        write_coord_names();
+    }
+
+    /// Define a block and write connectivity of a slice of its elements
+    ///
+    /// @param blk_id Block ID
+    /// @param elem_type Element type name
+    /// @param n_elems Number of elements in the block
+    /// @param n_nodes_per_elem Number of nodes per element
+    /// @param start First element of the slice within the block (1-based)
+    /// @param connect Connectivity of the slice (1-based)
+    template <typename INT>
+    void
+    write_partial_block(int64_t blk_id,
+                        const char * elem_type,
+                        int64_t n_elems,
+                        int64_t n_nodes_per_elem,
+                        int64_t start,
+                        const std::vector<INT> & connect)
+    {
+        check_int<INT>();
+        detail::check_ex(ex_put_block(this->exoid,
+                                      EX_ELEM_BLOCK,
+                                      blk_id,
+                                      elem_type,
+                                      n_elems,
+                                      n_nodes_per_elem,
+                                      0,
+                                      0,
+                                      0),
+                         "ex_put_block");
+        int64_t n = n_nodes_per_elem > 0 ? connect.size() / n_nodes_per_elem : 0;
+        detail::check_ex(ex_put_partial_conn(this->exoid,
+                                             EX_ELEM_BLOCK,
+                                             blk_id,
+                                             start,
+                                             n,
+                                             connect.data(),
+                                             nullptr,
+                                             nullptr),
+                         "ex_put_partial_conn");
+    }
+
+    /// Define a node set and write a slice of its entries
+    ///
+    /// @param id Node set ID
+    /// @param n Number of entries in the set
+    /// @param start First entry of the slice (1-based)
+    /// @param node_ids Node IDs of the slice (1-based)
+    template <typename INT>
+    void
+    write_partial_node_set(int64_t id, int64_t n, int64_t start, const std::vector<INT> & node_ids)
+    {
+        check_int<INT>();
+        detail::check_ex(ex_put_set_param(this->exoid, EX_NODE_SET, id, n, 0),
+                         "ex_put_set_param");
+        detail::check_ex(ex_put_partial_set(this->exoid,
+                                            EX_NODE_SET,
+                                            id,
+                                            start,
+                                            node_ids.size(),
+                                            node_ids.data(),
+                                            nullptr),
+                         "ex_put_partial_set");
+    }
+
+    /// Define a side set and write a slice of its entries
+    ///
+    /// @param id Side set ID
+    /// @param n Number of entries in the set
+    /// @param start First entry of the slice (1-based)
+    /// @param elem_ids Element IDs of the slice (1-based)
+    /// @param side_ids Side IDs of the slice (1-based)
+    template <typename INT>
+    void
+    write_partial_side_set(int64_t id,
+                           int64_t n,
+                           int64_t start,
+                           const std::vector<INT> & elem_ids,
+                           const std::vector<INT> & side_ids)
+    {
+        check_int<INT>();
+        assert(elem_ids.size() == side_ids.size());
+        detail::check_ex(ex_put_set_param(this->exoid, EX_SIDE_SET, id, n, 0),
+                         "ex_put_set_param");
+        detail::check_ex(ex_put_partial_set(this->exoid,
+                                            EX_SIDE_SET,
+                                            id,
+                                            start,
+                                            elem_ids.size(),
+                                            elem_ids.data(),
+                                            side_ids.data()),
+                         "ex_put_partial_set");
+    }
+
+    /// @param start First node of the slice (1-based)
+    void
+    write_partial_nodal_var(int step,
+                            int var_idx,
+                            int64_t start,
+                            const std::vector<double> & values)
+    {
+        detail::check_ex(ex_put_partial_var(this->exoid,
+                                            step,
+                                            EX_NODAL,
+                                            var_idx,
+                                            1,
+                                            start,
+                                            values.size(),
+                                            values.data()),
+                         "ex_put_partial_var");
+    }
+
+    /// @param start First element of the slice within the block (1-based)
+    void
+    write_partial_elem_var(int step,
+                           int var_idx,
+                           int64_t blk_id,
+                           int64_t start,
+                           const std::vector<double> & values)
+    {
+        detail::check_ex(ex_put_partial_var(this->exoid,
+                                            step,
+                                            EX_ELEM_BLOCK,
+                                            var_idx,
+                                            blk_id,
+                                            start,
+                                            values.size(),
+                                            values.data()),
+                         "ex_put_partial_var");
+    }
+#endif
+
+    /// Flush buffered data to disk
+    void
+    update()
+    {
+        detail::check_ex(ex_update(this->exoid), "ex_update");
+    }
+
+    /// Number of nodes in the file
+    int64_t
+    num_nodes() const
+    {
+        return ex_inquire_int(this->exoid, EX_INQ_NODES);
+    }
+
+    /// Number of time steps in the file
+    int
+    num_times() const
+    {
+        return static_cast<int>(ex_inquire_int(this->exoid, EX_INQ_TIME));
+    }
+
+    /// @param step Time step index (1-based)
+    double
+    time(int step) const
+    {
+        double t = 0;
+        detail::check_ex(ex_get_time(this->exoid, step, &t), "ex_get_time");
+        return t;
+    }
+
+    /// Names of variables already defined in the file
+    std::vector<std::string>
+    variable_names(ex_entity_type type) const
+    {
+        auto name_len =
+            static_cast<int>(ex_inquire_int(this->exoid, EX_INQ_DB_MAX_USED_NAME_LENGTH));
+        name_len = std::max(name_len, MAX_STR_LENGTH);
+        ex_set_max_name_length(this->exoid, name_len);
+        return detail::read_variable_names(this->exoid, type, name_len);
+    }
+
+    /// Element variable truth table already defined in the file, laid out as for
+    /// `write_elem_truth_table()`
+    std::vector<int>
+    elem_truth_table(int n_blocks, int n_vars) const
+    {
+        std::vector<int> table(static_cast<std::size_t>(n_blocks) * n_vars);
+        if (!table.empty())
+            detail::check_ex(
+                ex_get_truth_table(this->exoid, EX_ELEM_BLOCK, n_blocks, n_vars, table.data()),
+                "ex_get_truth_table");
+        return table;
+    }
+
+private:
+    ExoWriter(int exoid, bool int64) : exoid(exoid), int64(int64) {}
+
+    template <typename INT>
+    void
+    check_int() const
+    {
+        static_assert(sizeof(INT) == 4 || sizeof(INT) == 8, "Unsupported integer type");
+        if ((sizeof(INT) == 8) != this->int64)
+            throw std::logic_error("Integer size does not match the file's integer API");
+    }
+
+    void
+    write_coord_names()
+    {
+        char x[] = "x", y[] = "y", z[] = "z";
+        char * names[] = { x, y, z };
+        detail::check_ex(ex_put_coord_names(this->exoid, names), "ex_put_coord_names");
+    }
+
+    void
+    write_var_names(ex_entity_type type, const std::vector<std::string> & names)
+    {
+        // exodus warns about defining zero variables
+        if (names.empty())
+            return;
+        int n = static_cast<int>(names.size());
+        detail::check_ex(ex_put_variable_param(this->exoid, type, n), "ex_put_variable_param");
+        std::vector<char *> ptrs;
+        for (auto & nm : names)
+            ptrs.push_back(const_cast<char *>(nm.c_str()));
+        detail::check_ex(ex_put_variable_names(this->exoid, type, n, ptrs.data()),
+                         "ex_put_variable_names");
+    }
+
+    int exoid;
+    /// Integer API is 64-bit
+    bool int64;
+};
@@ -0,0 +1,242 @@
+// SPDX-FileCopyrightText: 2025 (c) David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "snap_key.h"
+#include <unistd.h>
+#include <fmt/core.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+/// External-memory node numbering by sorting snapped coordinates
+///
+/// Same numbering as `sort_dedup()`, but the (snap key, file, local index) records are collected in
+/// a buffer bounded by the memory budget. Full buffers are sorted and spilled as runs to scratch
+/// files, which are k-way merged at the end to assign global IDs in key order. Only the buffer and
+/// one read buffer per run are held in memory, the coordinates themselves are not kept at all.
+///
+/// @tparam INT Type of global node IDs
+template <typename INT>
+class ExternalDedup {
+public:
+    /// @param tol Snap tolerance
+    /// @param mem_limit Memory budget for records in bytes
+    /// @param scratch_dir Directory for sorted runs
+    ExternalDedup(double tol, std::size_t mem_limit, const std::string & scratch_dir) :
+        inv_tol(1. / tol),
+        capacity(std::max(mem_limit / sizeof(Record), MIN_RECORDS)),
+        scratch_dir(scratch_dir),
+        bytes_spilled(0)
+    {
+    }
+
+    ~ExternalDedup()
+    {
+        std::error_code ec;
+        for (auto & run : this->runs)
+            std::filesystem::remove(run, ec);
+    }
+
+    ExternalDedup(const ExternalDedup &) = delete;
+    ExternalDedup & operator=(const ExternalDedup &) = delete;
+
+    /// Add points of the next input file
+    ///
+    /// @param x x-coordinates of the input's nodes
+    /// @param y y-coordinates of the input's nodes
+    /// @param z z-coordinates of the input's nodes
+    template <typename X, typename Y, typename Z>
+    void
+    add(const X & x, const Y & y, const Z & z)
+    {
+        auto file = static_cast<uint32_t>(this->n_points.size());
+        std::size_t n = x.size();
+        if (n > std::numeric_limits<uint32_t>::max())
+            throw std::runtime_error("Too many nodes in one input for external dedup");
+        this->n_points.push_back(n);
+        // grow geometrically, but never past the budget
+        auto cap = this->buffer.capacity();
+        if (this->buffer.size() + n > cap)
+            this->buffer.reserve(
+                std::min(this->capacity, std::max(this->buffer.size() + n, 2 * cap)));
+        for (std::size_t i = 0; i < n; ++i) {
+            this->buffer.push_back({ snap_key(x[i], this->inv_tol),
+                                     snap_key(y[i], this->inv_tol),
+                                     snap_key(z[i], this->inv_tol),
+                                     file,
+                                     static_cast<uint32_t>(i) });
+            if (this->buffer.size() == this->capacity)
+                spill();
+        }
+    }
+
+    /// Assign global IDs
+    ///
+    /// @param index_set File index -> global node IDs (0-based)
+    /// @return Number of unique nodes
+    std::size_t
+    finish(std::map<int, std::vector<INT>> & index_set)
+    {
+        for (std::size_t fi = 0; fi < this->n_points.size(); ++fi)
+            index_set[fi].resize(this->n_points[fi]);
+
+        std::size_t n_unique = 0;
+        Record last {};
+        auto number = [&](const Record & r) {
+            if (n_unique == 0 || !same_key(r, last))
+                n_unique++;
+            last = r;
+            index_set[r.file][r.local] = n_unique - 1;
+        };
+
+        if (this->runs.empty()) {
+            // everything fit into memory
+            std::sort(this->buffer.begin(), this->buffer.end());
+            for (auto & r : this->buffer)
+                number(r);
+            this->buffer = {};
+            return n_unique;
+        }
+
+        if (!this->buffer.empty())
+            spill();
+        this->buffer = {};
+        merge_runs(number);
+        return n_unique;
+    }
+
+    /// Bytes written to scratch files
+    uint64_t
+    spilled() const
+    {
+        return this->bytes_spilled;
+    }
+
+private:
+    struct Record {
+        int64_t kx, ky, kz;
+        uint32_t file;
+        uint32_t local;
+
+        bool
+        operator<(const Record & other) const
+        {
+            return std::tie(this->kx, this->ky, this->kz, this->file, this->local) <
+                   std::tie(other.kx, other.ky, other.kz, other.file, other.local);
+        }
+    };
+
+    /// Sequential reader of a sorted run
+    struct RunReader {
+        std::ifstream is;
+        std::vector<Record> buf;
+        std::size_t pos = 0;
+
+        RunReader(const std::string & filename, std::size_t n) :
+            is(filename, std::ios::binary),
+            buf()
+        {
+            if (!this->is)
+                throw std::runtime_error(fmt::format("Could not open scratch file '{}'", filename));
+            this->buf.reserve(n);
+        }
+
+        /// Current record, `nullptr` at the end of the run
+        const Record *
+        peek()
+        {
+            if (this->pos == this->buf.size()) {
+                this->buf.resize(this->buf.capacity());
+                this->is.read(reinterpret_cast<char *>(this->buf.data()),
+                              this->buf.size() * sizeof(Record));
+                this->buf.resize(this->is.gcount() / sizeof(Record));
+                this->pos = 0;
+                if (this->buf.empty())
+                    return nullptr;
+            }
+            return &this->buf[this->pos];
+        }
+    };
+
+    static bool
+    same_key(const Record & a, const Record & b)
+    {
+        return a.kx == b.kx && a.ky == b.ky && a.kz == b.kz;
+    }
+
+    /// Sort the buffer and write it out as a run
+    void
+    spill()
+    {
+        std::sort(this->buffer.begin(), this->buffer.end());
+        auto filename = fmt::format("{}/exo-join-{}-{}-{}.run",
+                                    this->scratch_dir,
+                                    getpid(),
+                                    fmt::ptr(this),
+                                    this->runs.size());
+        std::ofstream os(filename, std::ios::binary | std::ios::trunc);
+        if (!os)
+            throw std::runtime_error(fmt::format("Could not create scratch file '{}'", filename));
+        this->runs.push_back(filename);
+        auto bytes = this->buffer.size() * sizeof(Record);
+        os.write(reinterpret_cast<const char *>(this->buffer.data()), bytes);
+        if (!os)
+            throw std::runtime_error(fmt::format("Could not write scratch file '{}'", filename));
+        this->bytes_spilled += bytes;
+        this->buffer.clear();
+    }
+
+    /// Merge all runs, calling `fn` on records in sorted order
+    template <typename FN>
+    void
+    merge_runs(FN && fn)
+    {
+        // the budget is split between the read buffers
+        auto n_buf = std::max(this->capacity / this->runs.size(), MIN_READ_RECORDS);
+        std::vector<RunReader> readers;
+        readers.reserve(this->runs.size());
+        for (auto & run : this->runs)
+            readers.emplace_back(run, n_buf);
+
+        auto greater = [&](std::size_t a, std::size_t b) {
+            return *readers[b].peek() < *readers[a].peek();
+        };
+        std::priority_queue<std::size_t, std::vector<std::size_t>, decltype(greater)> heap(greater);
+        for (std::size_t r = 0; r < readers.size(); ++r)
+            if (readers[r].peek() != nullptr)
+                heap.push(r);
+        while (!heap.empty()) {
+            auto r = heap.top();
+            heap.pop();
+            fn(*readers[r].peek());
+            readers[r].pos++;
+            if (readers[r].peek() != nullptr)
+                heap.push(r);
+        }
+    }
+
+    static constexpr std::size_t MIN_RECORDS = 1 << 16;
+    static constexpr std::size_t MIN_READ_RECORDS = 1 << 12;
+
+    double inv_tol;
+    /// Number of records that fit into the memory budget
+    std::size_t capacity;
+    std::string scratch_dir;
+    uint64_t bytes_spilled;
+    std::vector<Record> buffer;
+    /// File index -> number of points
+    std::vector<std::size_t> n_points;
+    /// Scratch files with sorted runs
+    std::vector<std::string> runs;
+};
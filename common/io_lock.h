@@ -0,0 +1,24 @@
+// SPDX-FileCopyrightText: 2025 (c) David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <exodusII.h>
+#include <mutex>
+
+/// Guards calls into the exodusII library
+inline std::recursive_mutex io_mutex;
+
+/// Lock the exodusII library for the calling thread
+///
+/// netCDF and HDF5 are not thread-safe unless built so, which means that worker threads can
+/// overlap I/O with other work, but not I/O with each other.
+inline std::unique_lock<std::recursive_mutex>
+lock_io()
+{
+#ifdef EXODUS_THREADSAFE
+    return std::unique_lock<std::recursive_mutex>(io_mutex, std::defer_lock);
+#else
+    return std::unique_lock<std::recursive_mutex>(io_mutex);
+#endif
+}
@@ -0,0 +1,209 @@
+// SPDX-FileCopyrightText: 2025 (c) David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "binary_io.h"
+#include "exo_header.h"
+#include <fmt/core.h>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/// Mesh layout of one input file, used to check that inputs did not change between joins
+struct InputSignature {
+    struct Block {
+        int64_t id;
+        int64_t n_elems;
+        int64_t n_nodes_per_elem;
+
+        bool operator==(const Block &) const = default;
+    };
+
+    int64_t n_nodes;
+    int64_t n_elems;
+    std::vector<Block> blocks;
+
+    bool operator==(const InputSignature &) const = default;
+};
+
+/// Signature of an input file from its header
+inline InputSignature
+input_signature(const ExoHeader & hdr)
+{
+    InputSignature sig;
+    sig.n_nodes = hdr.n_nodes;
+    sig.n_elems = hdr.n_elems;
+    for (auto & blk : hdr.blocks)
+        sig.blocks.push_back({ blk.id, blk.n_elems, blk.n_nodes_per_elem });
+    return sig;
+}
+
+/// Where the nodes and elements of each input file went in a joined file
+///
+/// Stored next to the joined file, so that later joins of the same inputs can skip the geometry.
+/// The binary format uses the native byte order.
+///
+/// @tparam INT Type of global node IDs and element positions
+template <typename INT>
+struct JoinMap {
+    /// Signature of every input file
+    std::vector<InputSignature> inputs;
+    /// Number of global nodes
+    int64_t n_nodes = 0;
+    /// Block ID -> number of elements in the joined block
+    std::map<int64_t, int64_t> block_n_elems;
+    /// File index -> global node IDs (0-based)
+    std::map<int, std::vector<INT>> index_set;
+    /// File index -> block ID -> positions (0-based, within the block) of the file's elements
+    std::vector<std::map<int64_t, std::vector<INT>>> elem_dest;
+};
+
+namespace detail {
+
+constexpr FileMagic JOIN_MAP_MAGIC = { 'E', 'X', 'J', 'M', 'A', 'P', '0', '1' };
+
+inline std::ifstream
+open_join_map(const std::string & filename)
+{
+    std::ifstream is(filename, std::ios::binary);
+    if (!is)
+        throw std::runtime_error(fmt::format("Could not open join map '{}'", filename));
+    if (!read_magic(is, JOIN_MAP_MAGIC))
+        throw std::runtime_error(fmt::format("'{}' is not a join map", filename));
+    return is;
+}
+
+} // namespace detail
+
+/// Chain the contents of a buffer onto hash `h`
+///
+/// Fast non-cryptographic hash processing 8-byte words, used to key cached join maps.
+///
+/// @param h Hash so far
+/// @param data Buffer
+/// @param n Size of the buffer in bytes
+/// @return Updated hash
+inline uint64_t
+hash_bytes(uint64_t h, const void * data, std::size_t n)
+{
+    auto mix = [](uint64_t k) {
+        k ^= k >> 33;
+        k *= 0xFF51AFD7ED558CCDull;
+        k ^= k >> 33;
+        k *= 0xC4CEB9FE1A85EC53ull;
+        k ^= k >> 33;
+        return k;
+    };
+    auto * p = static_cast<const unsigned char *>(data);
+    uint64_t len = n;
+    for (; n >= sizeof(uint64_t); n -= sizeof(uint64_t), p += sizeof(uint64_t)) {
+        uint64_t w;
+        std::memcpy(&w, p, sizeof(w));
+        h = mix(h ^ w) + 0x9E3779B97F4A7C15ull;
+    }
+    uint64_t w = 0;
+    std::memcpy(&w, p, n);
+    return mix(h ^ w ^ len);
+}
+
+/// Chain a value onto hash `h`
+template <typename T>
+inline uint64_t
+hash_value(uint64_t h, const T & val)
+{
+    return hash_bytes(h, &val, sizeof(T));
+}
+
+/// Name of the join map saved next to a joined file
+inline std::string
+join_map_filename(const std::string & output)
+{
+    return output + ".jmap";
+}
+
+/// Size in bytes of the IDs stored in a join map file
+inline int
+join_map_int_size(const std::string & filename)
+{
+    auto is = detail::open_join_map(filename);
+    return detail::read_pod<uint32_t>(is);
+}
+
+/// Save a join map, replacing the file with `detail::replace_file()`
+template <typename INT>
+void
+write_join_map(const std::string & filename, const JoinMap<INT> & map)
+{
+    auto written = detail::replace_file(filename, [&](std::ofstream & os) {
+        detail::write_magic(os, detail::JOIN_MAP_MAGIC);
+        detail::write_pod<uint32_t>(os, sizeof(INT));
+
+        detail::write_pod<uint64_t>(os, map.inputs.size());
+        for (auto & sig : map.inputs) {
+            detail::write_pod(os, sig.n_nodes);
+            detail::write_pod(os, sig.n_elems);
+            detail::write_array(os, sig.blocks);
+        }
+
+        detail::write_pod(os, map.n_nodes);
+        detail::write_pod<uint64_t>(os, map.block_n_elems.size());
+        for (auto & [id, n] : map.block_n_elems) {
+            detail::write_pod(os, id);
+            detail::write_pod(os, n);
+        }
+
+        for (std::size_t i = 0; i < map.inputs.size(); ++i)
+            detail::write_array(os, map.index_set.at(i));
+        for (auto & file_dest : map.elem_dest) {
+            detail::write_pod<uint64_t>(os, file_dest.size());
+            for (auto & [id, dest] : file_dest) {
+                detail::write_pod(os, id);
+                detail::write_array(os, dest);
+            }
+        }
+    });
+    if (!written)
+        throw std::runtime_error(fmt::format("Could not write join map '{}'", filename));
+}
+
+/// Load a join map
+template <typename INT>
+JoinMap<INT>
+read_join_map(const std::string & filename)
+{
+    auto is = detail::open_join_map(filename);
+    if (detail::read_pod<uint32_t>(is) != sizeof(INT))
+        throw std::runtime_error(fmt::format("Join map '{}' has a different ID size", filename));
+
+    JoinMap<INT> map;
+    map.inputs.resize(detail::read_pod<uint64_t>(is));
+    for (auto & sig : map.inputs) {
+        sig.n_nodes = detail::read_pod<int64_t>(is);
+        sig.n_elems = detail::read_pod<int64_t>(is);
+        sig.blocks = detail::read_array<InputSignature::Block>(is);
+    }
+
+    map.n_nodes = detail::read_pod<int64_t>(is);
+    auto n_blocks = detail::read_pod<uint64_t>(is);
+    for (uint64_t b = 0; b < n_blocks; ++b) {
+        auto id = detail::read_pod<int64_t>(is);
+        map.block_n_elems[id] = detail::read_pod<int64_t>(is);
+    }
+
+    for (std::size_t i = 0; i < map.inputs.size(); ++i)
+        map.index_set[i] = detail::read_array<INT>(is);
+    map.elem_dest.resize(map.inputs.size());
+    for (auto & file_dest : map.elem_dest) {
+        auto n = detail::read_pod<uint64_t>(is);
+        for (uint64_t b = 0; b < n; ++b) {
+            auto id = detail::read_pod<int64_t>(is);
+            file_dest[id] = detail::read_array<INT>(is);
+        }
+    }
+    return map;
+}
@@ -0,0 +1,412 @@
+// SPDX-FileCopyrightText: 2025 (c) David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    #define EXODUSII_UTILS_X86_KERNELS 1
+    #include <immintrin.h>
+#endif
+
+/// Instruction set used by the index kernels
+enum class KernelISA {
+    //
+    SCALAR,
+    AVX2,
+    AVX512
+};
+
+/// Best instruction set supported by the CPU we run on (detected once)
+inline KernelISA
+kernel_isa()
+{
+    static const KernelISA isa = [] {
+#ifdef EXODUSII_UTILS_X86_KERNELS
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f"))
+            return KernelISA::AVX512;
+        else if (__builtin_cpu_supports("avx2"))
+            return KernelISA::AVX2;
+#endif
+        return KernelISA::SCALAR;
+    }();
+    return isa;
+}
+
+/// Number of values, their extremes and power sums
+///
+/// Results for NaN values are unspecified.
+struct Moments {
+    int64_t n = 0;
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+    double sum = 0.;
+    double sum_sq = 0.;
+
+    /// Add values summarized by `other`
+    void
+    merge(const Moments & other)
+    {
+        this->n += other.n;
+        this->min = std::min(this->min, other.min);
+        this->max = std::max(this->max, other.max);
+        this->sum += other.sum;
+        this->sum_sq += other.sum_sq;
+    }
+
+    double
+    mean() const
+    {
+        return this->n > 0 ? this->sum / this->n : std::numeric_limits<double>::quiet_NaN();
+    }
+
+    /// Discrete L2 norm, i.e. the square root of the sum of squares
+    double
+    l2() const
+    {
+        return std::sqrt(this->sum_sq);
+    }
+};
+
+namespace detail {
+
+inline Moments
+moments_scalar(const double * vals, std::size_t n)
+{
+    Moments m;
+    m.n = n;
+    for (std::size_t i = 0; i < n; ++i) {
+        m.min = std::min(m.min, vals[i]);
+        m.max = std::max(m.max, vals[i]);
+        m.sum += vals[i];
+        m.sum_sq += vals[i] * vals[i];
+    }
+    return m;
+}
+
+template <typename INT>
+inline void
+remap_scalar(INT * connect, std::size_t n, const INT * is)
+{
+    for (std::size_t i = 0; i < n; ++i)
+        connect[i] = is[connect[i] - 1] + 1;
+}
+
+template <typename IDX>
+inline void
+scatter_scalar(std::size_t n_vars,
+               const double * const * src,
+               const IDX * idx,
+               std::size_t n,
+               double * const * dest)
+{
+    if (n_vars == 1) {
+        for (std::size_t i = 0; i < n; ++i)
+            dest[0][idx[i]] = src[0][i];
+    }
+    else {
+        for (std::size_t i = 0; i < n; ++i) {
+            auto j = idx[i];
+            for (std::size_t v = 0; v < n_vars; ++v)
+                dest[v][j] = src[v][i];
+        }
+    }
+}
+
+template <typename SRC_IDX, typename DEST_IDX>
+inline void
+copy_indexed_scalar(std::size_t n_vars,
+                    const double * const * src,
+                    const SRC_IDX * src_idx,
+                    const DEST_IDX * dest_idx,
+                    std::size_t n,
+                    double * const * dest)
+{
+    for (std::size_t v = 0; v < n_vars; ++v) {
+        const double * s = src[v];
+        double * d = dest[v];
+        for (std::size_t k = 0; k < n; ++k)
+            d[dest_idx[k]] = s[src_idx[k]];
+    }
+}
+
+#ifdef EXODUSII_UTILS_X86_KERNELS
+
+__attribute__((target("avx2"))) inline void
+remap_avx2(int * connect, std::size_t n, const int * is)
+{
+    const __m256i one = _mm256_set1_epi32(1);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        auto * p = reinterpret_cast<__m256i *>(connect + i);
+        __m256i idx = _mm256_sub_epi32(_mm256_loadu_si256(p), one);
+        __m256i gid = _mm256_i32gather_epi32(is, idx, 4);
+        _mm256_storeu_si256(p, _mm256_add_epi32(gid, one));
+    }
+    remap_scalar(connect + i, n - i, is);
+}
+
+__attribute__((target("avx512f"))) inline void
+remap_avx512(int * connect, std::size_t n, const int * is)
+{
+    const __m512i one = _mm512_set1_epi32(1);
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i idx = _mm512_sub_epi32(_mm512_loadu_si512(connect + i), one);
+        __m512i gid = _mm512_i32gather_epi32(idx, is, 4);
+        _mm512_storeu_si512(connect + i, _mm512_add_epi32(gid, one));
+    }
+    remap_scalar(connect + i, n - i, is);
+}
+
+__attribute__((target("avx2"))) inline Moments
+moments_avx2(const double * vals, std::size_t n)
+{
+    __m256d lo = _mm256_set1_pd(std::numeric_limits<double>::infinity());
+    __m256d hi = _mm256_set1_pd(-std::numeric_limits<double>::infinity());
+    __m256d sum = _mm256_setzero_pd();
+    __m256d sum_sq = _mm256_setzero_pd();
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d v = _mm256_loadu_pd(vals + i);
+        lo = _mm256_min_pd(lo, v);
+        hi = _mm256_max_pd(hi, v);
+        sum = _mm256_add_pd(sum, v);
+        sum_sq = _mm256_add_pd(sum_sq, _mm256_mul_pd(v, v));
+    }
+    alignas(32) double l[4], h[4], s[4], q[4];
+    _mm256_store_pd(l, lo);
+    _mm256_store_pd(h, hi);
+    _mm256_store_pd(s, sum);
+    _mm256_store_pd(q, sum_sq);
+    auto m = moments_scalar(vals + i, n - i);
+    m.n = n;
+    for (int k = 0; k < 4; ++k) {
+        m.min = std::min(m.min, l[k]);
+        m.max = std::max(m.max, h[k]);
+        m.sum += s[k];
+        m.sum_sq += q[k];
+    }
+    return m;
+}
+
+__attribute__((target("avx512f"))) inline Moments
+moments_avx512(const double * vals, std::size_t n)
+{
+    __m512d lo = _mm512_set1_pd(std::numeric_limits<double>::infinity());
+    __m512d hi = _mm512_set1_pd(-std::numeric_limits<double>::infinity());
+    __m512d sum = _mm512_setzero_pd();
+    __m512d sum_sq = _mm512_setzero_pd();
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d v = _mm512_loadu_pd(vals + i);
+        lo = _mm512_min_pd(lo, v);
+        hi = _mm512_max_pd(hi, v);
+        sum = _mm512_add_pd(sum, v);
+        sum_sq = _mm512_fmadd_pd(v, v, sum_sq);
+    }
+    auto m = moments_scalar(vals + i, n - i);
+    m.n = n;
+    m.min = std::min(m.min, _mm512_reduce_min_pd(lo));
+    m.max = std::max(m.max, _mm512_reduce_max_pd(hi));
+    m.sum += _mm512_reduce_add_pd(sum);
+    m.sum_sq += _mm512_reduce_add_pd(sum_sq);
+    return m;
+}
+
+/// AVX-512 scatter; when lanes collide, the highest lane wins, same as the sequential loop
+__attribute__((target("avx512f"))) inline void
+scatter_avx512(std::size_t n_vars,
+               const double * const * src,
+               const int * idx,
+               std::size_t n,
+               double * const * dest)
+{
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i j = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(idx + i));
+        for (std::size_t v = 0; v < n_vars; ++v)
+            _mm512_i32scatter_pd(dest[v], j, _mm512_loadu_pd(src[v] + i), 8);
+    }
+    for (; i < n; ++i)
+        for (std::size_t v = 0; v < n_vars; ++v)
+            dest[v][idx[i]] = src[v][i];
+}
+
+__attribute__((target("avx512f"))) inline void
+copy_indexed_avx512(std::size_t n_vars,
+                    const double * const * src,
+                    const int * src_idx,
+                    const int * dest_idx,
+                    std::size_t n,
+                    double * const * dest)
+{
+    std::size_t k = 0;
+    for (; k + 8 <= n; k += 8) {
+        __m256i si = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src_idx + k));
+        __m256i di = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dest_idx + k));
+        for (std::size_t v = 0; v < n_vars; ++v)
+            _mm512_i32scatter_pd(dest[v], di, _mm512_i32gather_pd(si, src[v], 8), 8);
+    }
+    for (; k < n; ++k)
+        for (std::size_t v = 0; v < n_vars; ++v)
+            dest[v][dest_idx[k]] = src[v][src_idx[k]];
+}
+
+#endif
+
+} // namespace detail
+
+/// Map local node indices in a connectivity array into global ones
+///
+/// The vector kernels handle 32-bit indices only, 64-bit ones use the scalar loop.
+///
+/// @param connect Block connectivity (from exodusii) - 1-based indexing
+/// @param n Number of entries in `connect`
+/// @param is Local node index (0-based) -> global node ID (0-based)
+template <typename INT>
+inline void
+remap_connectivity(INT * connect, std::size_t n, const std::vector<INT> & is)
+{
+#ifdef EXODUSII_UTILS_X86_KERNELS
+    if constexpr (std::is_same_v<INT, int>) {
+        switch (kernel_isa()) {
+        case KernelISA::AVX512:
+            return detail::remap_avx512(connect, n, is.data());
+        case KernelISA::AVX2:
+            return detail::remap_avx2(connect, n, is.data());
+        default:
+            break;
+        }
+    }
+#endif
+    detail::remap_scalar(connect, n, is.data());
+}
+
+/// Map local node indices in a connectivity array into global ones
+///
+/// @param connect Block connectivity (from exodusii) - 1-based indexing
+/// @param is Local node index (0-based) -> global node ID (0-based)
+template <typename INT>
+inline void
+remap_connectivity(std::vector<INT> & connect, const std::vector<INT> & is)
+{
+    remap_connectivity(connect.data(), connect.size(), is);
+}
+
+/// Scatter several arrays through the same index map in a single pass over `idx`
+///
+/// `dest[v][idx[i]] = src[v][i]` for every variable `v`
+///
+/// @param src Source arrays, all of the same size as `idx`
+/// @param idx Index map
+/// @param dest Destination arrays, one per source array
+template <typename IDX>
+inline void
+scatter(const std::vector<std::vector<double>> & src,
+        const std::vector<IDX> & idx,
+        std::vector<std::vector<double>> & dest)
+{
+    assert(src.size() == dest.size());
+    auto n_vars = src.size();
+    std::vector<const double *> src_ptrs(n_vars);
+    std::vector<double *> dest_ptrs(n_vars);
+    for (std::size_t v = 0; v < n_vars; ++v) {
+        assert(src[v].size() == idx.size());
+        src_ptrs[v] = src[v].data();
+        dest_ptrs[v] = dest[v].data();
+    }
+#ifdef EXODUSII_UTILS_X86_KERNELS
+    // AVX2 has no scatter instruction, so it uses the scalar loop
+    if constexpr (std::is_same_v<IDX, int>)
+        if (kernel_isa() == KernelISA::AVX512)
+            return detail::scatter_avx512(
+                n_vars, src_ptrs.data(), idx.data(), idx.size(), dest_ptrs.data());
+#endif
+    detail::scatter_scalar(n_vars, src_ptrs.data(), idx.data(), idx.size(), dest_ptrs.data());
+}
+
+/// Scatter values from `src` into `dest` using `idx` as a map
+template <typename IDX>
+inline void
+scatter(const std::vector<double> & src, const std::vector<IDX> & idx, std::vector<double> & dest)
+{
+    assert(src.size() == idx.size());
+    const double * src_ptr = src.data();
+    double * dest_ptr = dest.data();
+#ifdef EXODUSII_UTILS_X86_KERNELS
+    if constexpr (std::is_same_v<IDX, int>)
+        if (kernel_isa() == KernelISA::AVX512)
+            return detail::scatter_avx512(1, &src_ptr, idx.data(), idx.size(), &dest_ptr);
+#endif
+    detail::scatter_scalar(1, &src_ptr, idx.data(), idx.size(), &dest_ptr);
+}
+
+/// Indexed copy of several arrays: `dest[v][dest_idx[k]] = src[v][src_idx[k]]` for every
+/// variable `v`
+///
+/// @param src Source arrays
+/// @param src_idx Indices into source arrays
+/// @param dest_idx Indices into destination arrays, same size as `src_idx`
+/// @param dest Destination arrays, one per source array
+template <typename SRC_IDX, typename DEST_IDX>
+inline void
+copy_indexed(const std::vector<std::vector<double>> & src,
+             const std::vector<SRC_IDX> & src_idx,
+             const std::vector<DEST_IDX> & dest_idx,
+             std::vector<std::vector<double>> & dest)
+{
+    assert(src.size() == dest.size());
+    assert(src_idx.size() == dest_idx.size());
+    auto n_vars = src.size();
+    std::vector<const double *> src_ptrs(n_vars);
+    std::vector<double *> dest_ptrs(n_vars);
+    for (std::size_t v = 0; v < n_vars; ++v) {
+        src_ptrs[v] = src[v].data();
+        dest_ptrs[v] = dest[v].data();
+    }
+#ifdef EXODUSII_UTILS_X86_KERNELS
+    if constexpr (std::is_same_v<SRC_IDX, int> && std::is_same_v<DEST_IDX, int>)
+        if (kernel_isa() == KernelISA::AVX512)
+            return detail::copy_indexed_avx512(n_vars,
+                                               src_ptrs.data(),
+                                               src_idx.data(),
+                                               dest_idx.data(),
+                                               src_idx.size(),
+                                               dest_ptrs.data());
+#endif
+    detail::copy_indexed_scalar(
+        n_vars, src_ptrs.data(), src_idx.data(), dest_idx.data(), src_idx.size(), dest_ptrs.data());
+}
+
+/// Summarize an array of values
+///
+/// The vector kernels sum in a different order than the scalar loop, so sums may differ in the
+/// last bits.
+///
+/// @param vals Values
+/// @param n Number of values
+inline Moments
+moments(const double * vals, std::size_t n)
+{
+#ifdef EXODUSII_UTILS_X86_KERNELS
+    switch (kernel_isa()) {
+    case KernelISA::AVX512:
+        return detail::moments_avx512(vals, n);
+    case KernelISA::AVX2:
+        return detail::moments_avx2(vals, n);
+    default:
+        break;
+    }
+#endif
+    return detail::moments_scalar(vals, n);
+}
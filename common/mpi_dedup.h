@@ -0,0 +1,313 @@
+// SPDX-FileCopyrightText: 2025 (c) David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "mpi_utils.h"
+#include "snap_key.h"
+#include <mpi.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <tuple>
+#include <vector>
+
+/// Global node numbering of one rank's points in a distributed join
+///
+/// Every global node is owned by exactly one rank. Each rank owns a contiguous range of global IDs,
+/// ranges follow rank order. A rank owns its points that cannot coincide with points of other
+/// ranks, followed by the points on shared interfaces whose snap keys hash to the rank.
+template <typename INT>
+struct DistributedNodes {
+    /// Global ID (0-based) of every local point
+    std::vector<INT> ids;
+    /// First global ID owned by this rank
+    int64_t first = 0;
+    /// Total number of global nodes
+    int64_t n_global = 0;
+    /// Coordinates of owned nodes
+    std::vector<double> x, y, z;
+
+    /// Owned nodes whose values are available locally: local point -> owned index
+    std::vector<int64_t> local_src;
+    std::vector<int64_t> local_dest;
+    /// Local points whose values are sent to their owners, grouped by owner rank
+    std::vector<int64_t> send_src;
+    std::vector<int> send_counts, send_displs;
+    /// Owned indices of values received from other ranks, grouped by source rank
+    std::vector<int64_t> recv_dest;
+    std::vector<int> recv_counts, recv_displs;
+
+    /// Number of owned nodes
+    std::size_t
+    n_owned() const
+    {
+        return this->x.size();
+    }
+};
+
+namespace detail {
+
+/// Snap key of a point
+struct SnapKey {
+    int64_t kx, ky, kz;
+
+    bool
+    operator<(const SnapKey & other) const
+    {
+        return std::tie(this->kx, this->ky, this->kz) < std::tie(other.kx, other.ky, other.kz);
+    }
+
+    bool
+    operator==(const SnapKey & other) const = default;
+
+    /// Rank owning the key
+    int
+    owner(int n_ranks) const
+    {
+        uint64_t h = this->kx * 0x9E3779B97F4A7C15ull;
+        h ^= this->ky * 0xC2B2AE3D27D4EB4Full + (h << 6) + (h >> 2);
+        h ^= this->kz * 0x165667B19E3779F9ull + (h << 6) + (h >> 2);
+        h ^= h >> 33;
+        return static_cast<int>(h % n_ranks);
+    }
+};
+
+/// Interface point sent to the rank owning its snap key
+struct KeyRecord {
+    SnapKey key;
+    double x, y, z;
+};
+
+/// Answer of the owner of a snap key
+struct KeyReply {
+    int64_t gid;
+    /// The receiving rank supplies the node's values
+    int64_t supplier;
+};
+
+} // namespace detail
+
+/// Distributed node numbering by snapped coordinates
+///
+/// Points are merged when they snap to the same point of a grid with spacing `tol`, same as
+/// `sort_dedup()`. Points are first merged within each rank. Only points lying where the bounding
+/// boxes of two ranks overlap can coincide with other ranks' points; those go to the rank their
+/// snap key hashes to, which numbers them and answers with the global ID. Coordinates of such a
+/// node and its variable values are taken from the lowest rank that has it.
+///
+/// @param comm Communicator
+/// @param x x-coordinates of this rank's points
+/// @param y y-coordinates of this rank's points
+/// @param z z-coordinates of this rank's points
+/// @param tol Snap tolerance
+template <typename INT>
+DistributedNodes<INT>
+distributed_dedup(MPI_Comm comm,
+                  const std::vector<double> & x,
+                  const std::vector<double> & y,
+                  const std::vector<double> & z,
+                  double tol)
+{
+    using detail::KeyRecord;
+    using detail::KeyReply;
+    using detail::SnapKey;
+
+    int n_ranks = mpi_size(comm);
+    int rank = mpi_rank(comm);
+    auto n = x.size();
+    double inv_tol = 1. / tol;
+
+    // merge points of this rank
+    std::vector<std::pair<SnapKey, uint64_t>> recs(n);
+    for (std::size_t i = 0; i < n; ++i)
+        recs[i] = { { snap_key(x[i], inv_tol),
+                      snap_key(y[i], inv_tol),
+                      snap_key(z[i], inv_tol) },
+                    i };
+    std::sort(recs.begin(), recs.end(), [](const auto & a, const auto & b) {
+        return std::tie(a.first, a.second) < std::tie(b.first, b.second);
+    });
+    // unique point -> its key and first local point
+    std::vector<SnapKey> ukey;
+    std::vector<uint64_t> urep;
+    std::vector<std::size_t> point_u(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        if (i == 0 || !(recs[i].first == recs[i - 1].first)) {
+            ukey.push_back(recs[i].first);
+            urep.push_back(recs[i].second);
+        }
+        point_u[recs[i].second] = ukey.size() - 1;
+    }
+
+    // bounding boxes of all ranks
+    double bbox[6] = { std::numeric_limits<double>::max(),
+                       std::numeric_limits<double>::max(),
+                       std::numeric_limits<double>::max(),
+                       std::numeric_limits<double>::lowest(),
+                       std::numeric_limits<double>::lowest(),
+                       std::numeric_limits<double>::lowest() };
+    for (std::size_t i = 0; i < n; ++i) {
+        bbox[0] = std::min(bbox[0], x[i] - tol);
+        bbox[1] = std::min(bbox[1], y[i] - tol);
+        bbox[2] = std::min(bbox[2], z[i] - tol);
+        bbox[3] = std::max(bbox[3], x[i] + tol);
+        bbox[4] = std::max(bbox[4], y[i] + tol);
+        bbox[5] = std::max(bbox[5], z[i] + tol);
+    }
+    std::vector<double> bboxes(6 * n_ranks);
+    detail::check_mpi(
+        MPI_Allgather(bbox, 6, MPI_DOUBLE, bboxes.data(), 6, MPI_DOUBLE, comm),
+        "MPI_Allgather");
+    auto shared = [&](std::size_t pt) {
+        for (int r = 0; r < n_ranks; ++r) {
+            if (r == rank)
+                continue;
+            const double * b = &bboxes[6 * r];
+            if (b[0] <= x[pt] && x[pt] <= b[3] && b[1] <= y[pt] && y[pt] <= b[4] &&
+                b[2] <= z[pt] && z[pt] <= b[5])
+                return true;
+        }
+        return false;
+    };
+
+    // interface points go to the owners of their keys, the rest is owned here
+    DistributedNodes<INT> dn;
+    std::vector<std::vector<std::size_t>> to_rank(n_ranks);
+    std::vector<int64_t> owned_idx(ukey.size(), -1);
+    for (std::size_t u = 0; u < ukey.size(); ++u) {
+        if (shared(urep[u]))
+            to_rank[ukey[u].owner(n_ranks)].push_back(u);
+        else {
+            owned_idx[u] = dn.x.size();
+            dn.x.push_back(x[urep[u]]);
+            dn.y.push_back(y[urep[u]]);
+            dn.z.push_back(z[urep[u]]);
+            dn.local_src.push_back(urep[u]);
+            dn.local_dest.push_back(owned_idx[u]);
+        }
+    }
+
+    std::vector<KeyRecord> send;
+    std::vector<int> send_counts(n_ranks);
+    std::vector<std::size_t> sent_u;
+    for (int r = 0; r < n_ranks; ++r) {
+        send_counts[r] = to_rank[r].size();
+        for (auto u : to_rank[r]) {
+            send.push_back({ ukey[u], x[urep[u]], y[urep[u]], z[urep[u]] });
+            sent_u.push_back(u);
+        }
+    }
+    std::vector<int> recv_counts;
+    auto recv = alltoallv(comm, send, send_counts, recv_counts);
+
+    // number the received keys, the first record of each key (lowest source rank) supplies it
+    std::vector<int> recv_src(recv.size());
+    for (int r = 0, k = 0; r < n_ranks; ++r)
+        for (int c = 0; c < recv_counts[r]; ++c)
+            recv_src[k++] = r;
+    std::vector<std::size_t> order(recv.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return std::tie(recv[a].key, a) < std::tie(recv[b].key, b);
+    });
+    std::vector<int64_t> recv_idx(recv.size());
+    std::vector<char> recv_supplier(recv.size(), 0);
+    for (std::size_t k = 0; k < order.size(); ++k) {
+        auto i = order[k];
+        if (k == 0 || !(recv[i].key == recv[order[k - 1]].key)) {
+            recv_supplier[i] = 1;
+            dn.x.push_back(recv[i].x);
+            dn.y.push_back(recv[i].y);
+            dn.z.push_back(recv[i].z);
+        }
+        recv_idx[i] = dn.x.size() - 1;
+    }
+
+    int64_t n_owned = dn.x.size();
+    detail::check_mpi(MPI_Exscan(&n_owned, &dn.first, 1, MPI_INT64_T, MPI_SUM, comm),
+                      "MPI_Exscan");
+    if (rank == 0)
+        dn.first = 0;
+    detail::check_mpi(MPI_Allreduce(&n_owned, &dn.n_global, 1, MPI_INT64_T, MPI_SUM, comm),
+                      "MPI_Allreduce");
+
+    // answer in the order the records came in
+    std::vector<KeyReply> replies(recv.size());
+    dn.recv_counts.assign(n_ranks, 0);
+    for (std::size_t i = 0; i < recv.size(); ++i) {
+        replies[i] = { dn.first + recv_idx[i], recv_supplier[i] };
+        if (recv_supplier[i]) {
+            dn.recv_dest.push_back(recv_idx[i]);
+            dn.recv_counts[recv_src[i]]++;
+        }
+    }
+    std::vector<int> reply_counts;
+    auto answers = alltoallv(comm, replies, recv_counts, reply_counts);
+
+    std::vector<int64_t> ugid(ukey.size());
+    for (std::size_t u = 0; u < ukey.size(); ++u)
+        if (owned_idx[u] >= 0)
+            ugid[u] = dn.first + owned_idx[u];
+    dn.send_counts.assign(n_ranks, 0);
+    for (int r = 0, k = 0; r < n_ranks; ++r)
+        for (int c = 0; c < send_counts[r]; ++c, ++k) {
+            auto u = sent_u[k];
+            ugid[u] = answers[k].gid;
+            if (answers[k].supplier) {
+                dn.send_src.push_back(urep[u]);
+                dn.send_counts[r]++;
+            }
+        }
+
+    dn.send_displs.assign(n_ranks, 0);
+    dn.recv_displs.assign(n_ranks, 0);
+    for (int r = 1; r < n_ranks; ++r) {
+        dn.send_displs[r] = dn.send_displs[r - 1] + dn.send_counts[r - 1];
+        dn.recv_displs[r] = dn.recv_displs[r - 1] + dn.recv_counts[r - 1];
+    }
+
+    dn.ids.resize(n);
+    for (std::size_t i = 0; i < n; ++i)
+        dn.ids[i] = ugid[point_u[i]];
+    return dn;
+}
+
+/// Collect values of owned nodes from the values of all ranks' local points
+///
+/// Collective, only values of interface nodes travel between ranks.
+///
+/// @param comm Communicator
+/// @param dn Node numbering
+/// @param local Values of this rank's points
+/// @param owned Values of owned nodes
+template <typename INT>
+void
+exchange_values(MPI_Comm comm,
+                const DistributedNodes<INT> & dn,
+                const std::vector<double> & local,
+                std::vector<double> & owned)
+{
+    owned.resize(dn.n_owned());
+    for (std::size_t k = 0; k < dn.local_src.size(); ++k)
+        owned[dn.local_dest[k]] = local[dn.local_src[k]];
+
+    std::vector<double> send(dn.send_src.size());
+    for (std::size_t k = 0; k < send.size(); ++k)
+        send[k] = local[dn.send_src[k]];
+    std::vector<double> recv(dn.recv_dest.size());
+    detail::check_mpi(MPI_Alltoallv(send.data(),
+                                    dn.send_counts.data(),
+                                    dn.send_displs.data(),
+                                    MPI_DOUBLE,
+                                    recv.data(),
+                                    dn.recv_counts.data(),
+                                    dn.recv_displs.data(),
+                                    MPI_DOUBLE,
+                                    comm),
+                      "MPI_Alltoallv");
+    for (std::size_t k = 0; k < recv.size(); ++k)
+        owned[dn.recv_dest[k]] = recv[k];
+}
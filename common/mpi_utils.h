@@ -0,0 +1,312 @@
+// SPDX-FileCopyrightText: 2025 (c) David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "exo_header.h"
+#include <mpi.h>
+#include <fmt/core.h>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+inline int
+mpi_rank(MPI_Comm comm)
+{
+    int rank = 0;
+    MPI_Comm_rank(comm, &rank);
+    return rank;
+}
+
+inline int
+mpi_size(MPI_Comm comm)
+{
+    int size = 1;
+    MPI_Comm_size(comm, &size);
+    return size;
+}
+
+namespace detail {
+
+/// Throw if an MPI call failed
+inline void
+check_mpi(int err, const char * what)
+{
+    if (err != MPI_SUCCESS)
+        throw std::runtime_error(fmt::format("MPI: {} failed with error {}", what, err));
+}
+
+/// Byte buffer for shipping structures between ranks
+struct PackBuffer {
+    std::vector<char> data;
+    std::size_t pos = 0;
+
+    template <typename T>
+    void
+    put(const T & val)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        auto * p = reinterpret_cast<const char *>(&val);
+        this->data.insert(this->data.end(), p, p + sizeof(T));
+    }
+
+    void
+    put(const std::string & str)
+    {
+        put<uint64_t>(str.size());
+        this->data.insert(this->data.end(), str.begin(), str.end());
+    }
+
+    void
+    put(const std::vector<std::string> & strs)
+    {
+        put<uint64_t>(strs.size());
+        for (auto & s : strs)
+            put(s);
+    }
+
+    template <typename T>
+    T
+    get()
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        if (this->pos + sizeof(T) > this->data.size())
+            throw std::runtime_error("Truncated MPI message");
+        T val;
+        std::memcpy(&val, this->data.data() + this->pos, sizeof(T));
+        this->pos += sizeof(T);
+        return val;
+    }
+
+    std::string
+    get_string()
+    {
+        auto n = get<uint64_t>();
+        if (this->pos + n > this->data.size())
+            throw std::runtime_error("Truncated MPI message");
+        std::string str(this->data.data() + this->pos, n);
+        this->pos += n;
+        return str;
+    }
+
+    std::vector<std::string>
+    get_strings()
+    {
+        std::vector<std::string> strs(get<uint64_t>());
+        for (auto & s : strs)
+            s = get_string();
+        return strs;
+    }
+};
+
+inline void
+pack_sets(PackBuffer & buf, const std::vector<SetHeader> & sets)
+{
+    buf.put<uint64_t>(sets.size());
+    for (auto & s : sets) {
+        buf.put(s.id);
+        buf.put(s.name);
+        buf.put(s.size);
+    }
+}
+
+inline std::vector<SetHeader>
+unpack_sets(PackBuffer & buf)
+{
+    std::vector<SetHeader> sets(buf.get<uint64_t>());
+    for (auto & s : sets) {
+        s.id = buf.get<int64_t>();
+        s.name = buf.get_string();
+        s.size = buf.get<int64_t>();
+    }
+    return sets;
+}
+
+inline void
+pack_header(PackBuffer & buf, const ExoHeader & hdr)
+{
+    buf.put(hdr.title);
+    buf.put(hdr.dim);
+    buf.put(hdr.n_nodes);
+    buf.put(hdr.n_elems);
+    buf.put<uint64_t>(hdr.blocks.size());
+    for (auto & blk : hdr.blocks) {
+        buf.put(blk.id);
+        buf.put(blk.name);
+        buf.put(blk.element_type);
+        buf.put(blk.n_elems);
+        buf.put(blk.n_nodes_per_elem);
+    }
+    pack_sets(buf, hdr.node_sets);
+    pack_sets(buf, hdr.side_sets);
+    buf.put(hdr.nodal_var_names);
+    buf.put(hdr.elem_var_names);
+    buf.put(hdr.global_var_names);
+    buf.put(hdr.n_times);
+    buf.put(hdr.int64);
+}
+
+inline ExoHeader
+unpack_header(PackBuffer & buf)
+{
+    ExoHeader hdr;
+    hdr.title = buf.get_string();
+    hdr.dim = buf.get<int>();
+    hdr.n_nodes = buf.get<int64_t>();
+    hdr.n_elems = buf.get<int64_t>();
+    hdr.blocks.resize(buf.get<uint64_t>());
+    for (auto & blk : hdr.blocks) {
+        blk.id = buf.get<int64_t>();
+        blk.name = buf.get_string();
+        blk.element_type = buf.get_string();
+        blk.n_elems = buf.get<int64_t>();
+        blk.n_nodes_per_elem = buf.get<int64_t>();
+    }
+    hdr.node_sets = unpack_sets(buf);
+    hdr.side_sets = unpack_sets(buf);
+    hdr.nodal_var_names = buf.get_strings();
+    hdr.elem_var_names = buf.get_strings();
+    hdr.global_var_names = buf.get_strings();
+    hdr.n_times = buf.get<int>();
+    hdr.int64 = buf.get<bool>();
+    return hdr;
+}
+
+} // namespace detail
+
+/// Exchange values between all ranks
+///
+/// Message sizes are limited to 2 GB per pair of ranks.
+///
+/// @param comm Communicator
+/// @param send Values to send, grouped by destination rank
+/// @param send_counts Number of values for each rank
+/// @param recv_counts Number of values received from each rank
+/// @return Received values, grouped by source rank
+template <typename T>
+std::vector<T>
+alltoallv(MPI_Comm comm,
+          const std::vector<T> & send,
+          const std::vector<int> & send_counts,
+          std::vector<int> & recv_counts)
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+    int n = mpi_size(comm);
+    recv_counts.assign(n, 0);
+    detail::check_mpi(
+        MPI_Alltoall(send_counts.data(), 1, MPI_INT, recv_counts.data(), 1, MPI_INT, comm),
+        "MPI_Alltoall");
+    std::vector<int> sc(n), sd(n), rc(n), rd(n);
+    int s = 0, r = 0;
+    for (int i = 0; i < n; ++i) {
+        sc[i] = send_counts[i] * sizeof(T);
+        sd[i] = s;
+        s += sc[i];
+        rc[i] = recv_counts[i] * sizeof(T);
+        rd[i] = r;
+        r += rc[i];
+    }
+    std::vector<T> recv(r / sizeof(T));
+    detail::check_mpi(MPI_Alltoallv(send.data(),
+                                    sc.data(),
+                                    sd.data(),
+                                    MPI_BYTE,
+                                    recv.data(),
+                                    rc.data(),
+                                    rd.data(),
+                                    MPI_BYTE,
+                                    comm),
+                      "MPI_Alltoallv");
+    return recv;
+}
+
+/// Concatenate the arrays of all ranks on `root`
+///
+/// @return Arrays in rank order on `root`, empty elsewhere
+template <typename T>
+std::vector<T>
+gather(MPI_Comm comm, const std::vector<T> & local, int root = 0)
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+    int n = mpi_size(comm);
+    int bytes = local.size() * sizeof(T);
+    std::vector<int> counts(n), displs(n);
+    detail::check_mpi(MPI_Gather(&bytes, 1, MPI_INT, counts.data(), 1, MPI_INT, root, comm),
+                      "MPI_Gather");
+    int total = 0;
+    for (int i = 0; i < n; ++i) {
+        displs[i] = total;
+        total += counts[i];
+    }
+    std::vector<T> all(mpi_rank(comm) == root ? total / sizeof(T) : 0);
+    detail::check_mpi(MPI_Gatherv(local.data(),
+                                  bytes,
+                                  MPI_BYTE,
+                                  all.data(),
+                                  counts.data(),
+                                  displs.data(),
+                                  MPI_BYTE,
+                                  root,
+                                  comm),
+                      "MPI_Gatherv");
+    return all;
+}
+
+/// Send an array from `root` to all ranks
+template <typename T>
+void
+broadcast(MPI_Comm comm, std::vector<T> & vals, int root = 0)
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+    uint64_t n = vals.size();
+    detail::check_mpi(MPI_Bcast(&n, 1, MPI_UINT64_T, root, comm), "MPI_Bcast");
+    vals.resize(n);
+    detail::check_mpi(MPI_Bcast(vals.data(), n * sizeof(T), MPI_BYTE, root, comm), "MPI_Bcast");
+}
+
+/// Share headers of every rank's input files with all ranks
+///
+/// @param comm Communicator
+/// @param local Headers of this rank's input files
+/// @return Headers of all input files, in rank order
+inline std::vector<ExoHeader>
+allgather_headers(MPI_Comm comm, const std::vector<ExoHeader> & local)
+{
+    detail::PackBuffer buf;
+    buf.put<uint64_t>(local.size());
+    for (auto & hdr : local)
+        detail::pack_header(buf, hdr);
+
+    int n = mpi_size(comm);
+    int bytes = buf.data.size();
+    std::vector<int> counts(n), displs(n);
+    detail::check_mpi(MPI_Allgather(&bytes, 1, MPI_INT, counts.data(), 1, MPI_INT, comm),
+                      "MPI_Allgather");
+    int total = 0;
+    for (int i = 0; i < n; ++i) {
+        displs[i] = total;
+        total += counts[i];
+    }
+    detail::PackBuffer all;
+    all.data.resize(total);
+    detail::check_mpi(MPI_Allgatherv(buf.data.data(),
+                                     bytes,
+                                     MPI_BYTE,
+                                     all.data.data(),
+                                     counts.data(),
+                                     displs.data(),
+                                     MPI_BYTE,
+                                     comm),
+                      "MPI_Allgatherv");
+
+    std::vector<ExoHeader> headers;
+    for (int i = 0; i < n; ++i) {
+        auto n_hdrs = all.get<uint64_t>();
+        for (uint64_t k = 0; k < n_hdrs; ++k)
+            headers.push_back(detail::unpack_header(all));
+    }
+    return headers;
+}
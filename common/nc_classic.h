@@ -0,0 +1,374 @@
+// SPDX-FileCopyrightText: 2025 (c) David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <fmt/core.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// netCDF external types
+enum NcType {
+    NC_TYPE_BYTE = 1,
+    NC_TYPE_CHAR = 2,
+    NC_TYPE_SHORT = 3,
+    NC_TYPE_INT = 4,
+    NC_TYPE_FLOAT = 5,
+    NC_TYPE_DOUBLE = 6,
+    NC_TYPE_UBYTE = 7,
+    NC_TYPE_USHORT = 8,
+    NC_TYPE_UINT = 9,
+    NC_TYPE_INT64 = 10,
+    NC_TYPE_UINT64 = 11
+};
+
+namespace detail {
+
+template <typename T>
+inline T
+from_big_endian(const unsigned char * p)
+{
+    static_assert(sizeof(T) == 4 || sizeof(T) == 8);
+    if constexpr (sizeof(T) == 4) {
+        uint32_t u;
+        std::memcpy(&u, p, sizeof(u));
+        if constexpr (std::endian::native == std::endian::little)
+            u = __builtin_bswap32(u);
+        return std::bit_cast<T>(u);
+    }
+    else {
+        uint64_t u;
+        std::memcpy(&u, p, sizeof(u));
+        if constexpr (std::endian::native == std::endian::little)
+            u = __builtin_bswap64(u);
+        return std::bit_cast<T>(u);
+    }
+}
+
+/// Size in bytes of a value of netCDF type `type`
+inline std::size_t
+nc_type_size(int type)
+{
+    switch (type) {
+    case NC_TYPE_BYTE:
+    case NC_TYPE_CHAR:
+    case NC_TYPE_UBYTE:
+        return 1;
+    case NC_TYPE_SHORT:
+    case NC_TYPE_USHORT:
+        return 2;
+    case NC_TYPE_INT:
+    case NC_TYPE_FLOAT:
+    case NC_TYPE_UINT:
+        return 4;
+    case NC_TYPE_DOUBLE:
+    case NC_TYPE_INT64:
+    case NC_TYPE_UINT64:
+        return 8;
+    default:
+        throw std::runtime_error(fmt::format("Unknown netCDF type {}", type));
+    }
+}
+
+template <typename T>
+constexpr int NC_TYPE_OF = 0;
+template <>
+constexpr int NC_TYPE_OF<int32_t> = NC_TYPE_INT;
+template <>
+constexpr int NC_TYPE_OF<int64_t> = NC_TYPE_INT64;
+template <>
+constexpr int NC_TYPE_OF<float> = NC_TYPE_FLOAT;
+template <>
+constexpr int NC_TYPE_OF<double> = NC_TYPE_DOUBLE;
+
+} // namespace detail
+
+/// Array of big-endian values stored in memory, converted to native byte order on access
+template <typename T>
+class BigEndianArray {
+public:
+    BigEndianArray(const unsigned char * data, std::size_t n) : data(data), n(n) {}
+
+    std::size_t
+    size() const
+    {
+        return this->n;
+    }
+
+    T
+    operator[](std::size_t i) const
+    {
+        return detail::from_big_endian<T>(this->data + i * sizeof(T));
+    }
+
+private:
+    const unsigned char * data;
+    std::size_t n;
+};
+
+/// Memory-mapped netCDF classic (CDF-1), 64-bit offset (CDF-2) or 64-bit data (CDF-5) file
+///
+/// Only the header is parsed, variable values are read straight from the mapping when accessed.
+/// netCDF-4 (HDF5) files are not supported, `open()` returns `nullptr` for them.
+class ClassicFile {
+public:
+    struct Var {
+        /// netCDF external type
+        int type;
+        /// Record variable (first dimension is the unlimited one)
+        bool record;
+        /// Number of values (per record for record variables)
+        std::size_t n;
+        /// File offset of the values (of the first record for record variables)
+        uint64_t begin;
+    };
+
+    /// Map a file
+    ///
+    /// @param filename File name
+    /// @return Mapped file, or `nullptr` if the file is not in one of the classic formats
+    static std::unique_ptr<ClassicFile>
+    open(const std::string & filename)
+    {
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error(fmt::format("Could not open file '{}'", filename));
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size < 4) {
+            ::close(fd);
+            return nullptr;
+        }
+        char magic[4];
+        if (pread(fd, magic, sizeof(magic), 0) != sizeof(magic) ||
+            std::memcmp(magic, "CDF", 3) != 0 ||
+            (magic[3] != 1 && magic[3] != 2 && magic[3] != 5)) {
+            ::close(fd);
+            return nullptr;
+        }
+        auto size = static_cast<std::size_t>(st.st_size);
+        void * addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED)
+            throw std::runtime_error(fmt::format("Could not map file '{}'", filename));
+        std::unique_ptr<ClassicFile> file(
+            new ClassicFile(static_cast<const unsigned char *>(addr), size));
+        file->parse_header(filename);
+        return file;
+    }
+
+    ~ClassicFile() { munmap(const_cast<unsigned char *>(this->base), this->size); }
+
+    ClassicFile(const ClassicFile &) = delete;
+    ClassicFile & operator=(const ClassicFile &) = delete;
+
+    /// Find a variable
+    ///
+    /// @return The variable or `nullptr` if the file does not have it
+    const Var *
+    find(const std::string & name) const
+    {
+        auto it = this->vars.find(name);
+        return it != this->vars.end() ? &it->second : nullptr;
+    }
+
+    /// Number of records
+    std::size_t
+    num_records() const
+    {
+        return this->n_records;
+    }
+
+    /// Values of a variable
+    ///
+    /// @param var Variable of type `T`
+    /// @param rec Record index (0-based), for record variables
+    template <typename T>
+    BigEndianArray<T>
+    array(const Var & var, std::size_t rec = 0) const
+    {
+        if (var.type != detail::NC_TYPE_OF<T>)
+            throw std::runtime_error("netCDF variable type mismatch");
+        return BigEndianArray<T>(this->base + offset(var, rec), var.n);
+    }
+
+    /// Ask the kernel to start reading values of a variable ahead of their use
+    void
+    prefetch(const Var & var, std::size_t rec = 0) const
+    {
+        auto page = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+        auto begin = offset(var, rec) / page * page;
+        auto end = offset(var, rec) + var.n * detail::nc_type_size(var.type);
+        madvise(const_cast<unsigned char *>(this->base) + begin, end - begin, MADV_WILLNEED);
+    }
+
+private:
+    ClassicFile(const unsigned char * base, std::size_t size) :
+        base(base),
+        size(size),
+        version(0),
+        n_records(0),
+        record_size(0)
+    {
+    }
+
+    uint64_t
+    offset(const Var & var, std::size_t rec) const
+    {
+        uint64_t off = var.begin + (var.record ? rec * this->record_size : 0);
+        if ((var.record && rec >= this->n_records) ||
+            off + var.n * detail::nc_type_size(var.type) > this->size)
+            throw std::runtime_error("netCDF variable is out of bounds of the file");
+        return off;
+    }
+
+    /// Sequential reader of the big-endian header
+    struct HeaderReader {
+        const unsigned char * p;
+        const unsigned char * end;
+        int version;
+
+        void
+        need(std::size_t n) const
+        {
+            if (static_cast<std::size_t>(this->end - this->p) < n)
+                throw std::runtime_error("Truncated netCDF header");
+        }
+
+        uint32_t
+        u32()
+        {
+            need(4);
+            auto v = detail::from_big_endian<uint32_t>(this->p);
+            this->p += 4;
+            return v;
+        }
+
+        uint64_t
+        u64()
+        {
+            need(8);
+            auto v = detail::from_big_endian<uint64_t>(this->p);
+            this->p += 8;
+            return v;
+        }
+
+        uint64_t
+        non_neg()
+        {
+            return this->version == 5 ? u64() : u32();
+        }
+
+        uint64_t
+        file_offset()
+        {
+            return this->version == 1 ? u32() : u64();
+        }
+
+        void
+        skip(uint64_t n)
+        {
+            // values are padded to 4 bytes
+            n = (n + 3) / 4 * 4;
+            need(n);
+            this->p += n;
+        }
+
+        std::string
+        name()
+        {
+            auto n = non_neg();
+            need(n);
+            std::string s(reinterpret_cast<const char *>(this->p), n);
+            skip(n);
+            return s;
+        }
+
+        void
+        skip_attributes()
+        {
+            u32();
+            auto n_atts = non_neg();
+            for (uint64_t a = 0; a < n_atts; ++a) {
+                name();
+                auto type = static_cast<int>(u32());
+                auto n = non_neg();
+                skip(n * detail::nc_type_size(type));
+            }
+        }
+    };
+
+    void
+    parse_header(const std::string & filename)
+    {
+        HeaderReader rd { this->base + 4, this->base + this->size, this->base[3] };
+        this->version = rd.version;
+        auto n_recs = rd.non_neg();
+        bool streaming = rd.version != 5 && n_recs == 0xFFFFFFFFu;
+
+        // dimensions: length 0 is the unlimited (record) dimension
+        rd.u32();
+        std::vector<uint64_t> dim_len(rd.non_neg());
+        for (auto & len : dim_len) {
+            rd.name();
+            len = rd.non_neg();
+        }
+
+        rd.skip_attributes();
+
+        rd.u32();
+        auto n_vars = rd.non_neg();
+        uint64_t first_record = 0;
+        for (uint64_t v = 0; v < n_vars; ++v) {
+            auto name = rd.name();
+            std::vector<uint64_t> dim_ids(rd.non_neg());
+            for (auto & id : dim_ids) {
+                id = rd.non_neg();
+                if (id >= dim_len.size())
+                    throw std::runtime_error(
+                        fmt::format("Invalid dimension ID in netCDF header of '{}'", filename));
+            }
+            rd.skip_attributes();
+            Var var;
+            var.type = static_cast<int>(rd.u32());
+            auto vsize = rd.non_neg();
+            var.begin = rd.file_offset();
+            var.record = !dim_ids.empty() && dim_len[dim_ids[0]] == 0;
+            var.n = 1;
+            for (std::size_t d = var.record ? 1 : 0; d < dim_ids.size(); ++d)
+                var.n *= dim_len[dim_ids[d]];
+            if (var.record) {
+                if (this->record_size == 0)
+                    first_record = var.begin;
+                this->record_size += vsize;
+            }
+            this->vars.emplace(std::move(name), var);
+        }
+
+        if (streaming && this->record_size > 0)
+            n_recs = (this->size - first_record) / this->record_size;
+        this->n_records = n_recs;
+    }
+
+    /// Start of the mapping
+    const unsigned char * base;
+    /// Size of the mapping
+    std::size_t size;
+    /// Format version (1, 2 or 5)
+    int version;
+    /// Number of records
+    std::size_t n_records;
+    /// Size of one record (all record variables)
+    uint64_t record_size;
+    /// Variables by name
+    std::unordered_map<std::string, Var> vars;
+};
@@ -0,0 +1,295 @@
+// SPDX-FileCopyrightText: 2025 (c) David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/// Spatial node deduplication on a uniform hash grid
+///
+/// Points are quantized into cubic cells of width `CELL_FACTOR * tol` and stored in a flat
+/// open-addressing (linear probing) hash table keyed on the integer cell coordinates. Two points
+/// are considered identical when they are within `tol` of each other in every coordinate. Since
+/// the cell is much wider than `tol`, only a point lying within `tol` of a cell face has to probe
+/// the neighboring cell across that face.
+///
+/// Unique nodes are stored in insertion order in contiguous coordinate arrays, so they can be
+/// written out directly. Nodes that are known not to coincide with any other node can be added
+/// with `append()`, which bypasses the hash table entirely.
+///
+/// @tparam INT Type of global node IDs
+template <typename INT = int>
+class NodeDedup {
+public:
+    /// @param tol Matching tolerance
+    explicit NodeDedup(double tol) :
+        tol(tol),
+        inv_h(1. / (CELL_FACTOR * tol)),
+        radius(1. / CELL_FACTOR),
+        mask(0),
+        n_hashed(0),
+        slots(),
+        xs(),
+        ys(),
+        zs()
+    {
+        rehash(MIN_CAPACITY);
+    }
+
+    /// Make room for at least `n` unique nodes, of which `n_match` go through `insert()`,
+    /// without reallocating or rehashing
+    ///
+    /// @param n Number of unique nodes
+    /// @param n_match Number of hashed nodes
+    void
+    reserve(std::size_t n, std::size_t n_match)
+    {
+        this->xs.reserve(n);
+        this->ys.reserve(n);
+        this->zs.reserve(n);
+        std::size_t cap = this->slots.size();
+        while (n_match > cap / 2)
+            cap *= 2;
+        if (cap != this->slots.size())
+            rehash(cap);
+    }
+
+    /// Make room for at least `n` unique nodes without reallocating or rehashing
+    ///
+    /// @param n Number of unique nodes
+    void
+    reserve(std::size_t n)
+    {
+        reserve(n, n);
+    }
+
+    /// Insert a point
+    ///
+    /// @param x x-coordinate
+    /// @param y y-coordinate
+    /// @param z z-coordinate
+    /// @return Global 0-based ID of the point (existing one if the point was already inserted)
+    INT
+    insert(double x, double y, double z)
+    {
+        double qx = x * this->inv_h;
+        double qy = y * this->inv_h;
+        double qz = z * this->inv_h;
+        auto cx = static_cast<int64_t>(std::floor(qx));
+        auto cy = static_cast<int64_t>(std::floor(qy));
+        auto cz = static_cast<int64_t>(std::floor(qz));
+
+        // own cell first, remembering where the probe sequence ended
+        auto h = hash(cx, cy, cz);
+        auto tag = static_cast<uint32_t>(h >> 32);
+        auto pos = h & this->mask;
+        for (; this->slots[pos].idx != EMPTY; pos = (pos + 1) & this->mask) {
+            const auto & s = this->slots[pos];
+            if (s.tag == tag && close(s.idx, x, y, z))
+                return s.idx;
+        }
+
+        // neighbor cells, only across faces the point is close to
+        int dx = neighbor_offset(qx - cx);
+        int dy = neighbor_offset(qy - cy);
+        int dz = neighbor_offset(qz - cz);
+        if (dx || dy || dz) {
+            for (int i = 0; i <= (dx != 0); ++i)
+                for (int j = 0; j <= (dy != 0); ++j)
+                    for (int k = 0; k <= (dz != 0); ++k) {
+                        if (i == 0 && j == 0 && k == 0)
+                            continue;
+                        auto idx = find(cx + i * dx, cy + j * dy, cz + k * dz, x, y, z);
+                        if (idx != EMPTY)
+                            return idx;
+                    }
+        }
+
+        // new node
+        INT idx = append(x, y, z);
+        this->slots[pos] = { tag, idx };
+        this->n_hashed++;
+        if (this->n_hashed > this->slots.size() / 2)
+            rehash(this->slots.size() * 2);
+        return idx;
+    }
+
+    /// Add a point without matching it against existing ones
+    ///
+    /// The point will not be found by subsequent `insert()` calls either.
+    ///
+    /// @param x x-coordinate
+    /// @param y y-coordinate
+    /// @param z z-coordinate
+    /// @return Global 0-based ID of the new point
+    INT
+    append(double x, double y, double z)
+    {
+        auto idx = static_cast<INT>(this->xs.size());
+        this->xs.push_back(x);
+        this->ys.push_back(y);
+        this->zs.push_back(z);
+        return idx;
+    }
+
+    /// Replace all nodes with the given ones
+    ///
+    /// The nodes are not hashed, i.e. they will not be found by subsequent `insert()` calls.
+    ///
+    /// @param x x-coordinates, indexed by global ID
+    /// @param y y-coordinates, indexed by global ID
+    /// @param z z-coordinates, indexed by global ID
+    void
+    assign(std::vector<double> && x, std::vector<double> && y, std::vector<double> && z)
+    {
+        this->xs = std::move(x);
+        this->ys = std::move(y);
+        this->zs = std::move(z);
+        this->slots.assign(this->slots.size(), { 0, EMPTY });
+        this->n_hashed = 0;
+    }
+
+    /// Renumber nodes
+    ///
+    /// @param order `order[k]` is the current ID of the node that gets ID `k`
+    void
+    permute(const std::vector<INT> & order)
+    {
+        std::vector<INT> new_id(order.size());
+        for (std::size_t k = 0; k < order.size(); ++k)
+            new_id[order[k]] = static_cast<INT>(k);
+        for (auto * c : { &this->xs, &this->ys, &this->zs }) {
+            std::vector<double> permuted(order.size());
+            for (std::size_t k = 0; k < order.size(); ++k)
+                permuted[k] = (*c)[order[k]];
+            std::swap(*c, permuted);
+        }
+        for (auto & s : this->slots)
+            if (s.idx != EMPTY)
+                s.idx = new_id[s.idx];
+    }
+
+    /// Number of unique nodes
+    std::size_t
+    size() const
+    {
+        return this->xs.size();
+    }
+
+    /// x-coordinates of unique nodes, indexed by global ID
+    const std::vector<double> &
+    x() const
+    {
+        return this->xs;
+    }
+
+    /// y-coordinates of unique nodes, indexed by global ID
+    const std::vector<double> &
+    y() const
+    {
+        return this->ys;
+    }
+
+    /// z-coordinates of unique nodes, indexed by global ID
+    const std::vector<double> &
+    z() const
+    {
+        return this->zs;
+    }
+
+private:
+    struct Slot {
+        /// Upper bits of the cell hash, to reject most mismatches without touching coordinates
+        uint32_t tag;
+        /// Node index or `EMPTY`
+        INT idx;
+    };
+
+    static uint64_t
+    hash(int64_t cx, int64_t cy, int64_t cz)
+    {
+        uint64_t h = static_cast<uint64_t>(cx) * 0x9E3779B97F4A7C15ull;
+        h ^= static_cast<uint64_t>(cy) * 0xC2B2AE3D27D4EB4Full;
+        h ^= static_cast<uint64_t>(cz) * 0x165667B19E3779F9ull;
+        h ^= h >> 29;
+        h *= 0xBF58476D1CE4E5B9ull;
+        h ^= h >> 32;
+        return h;
+    }
+
+    /// Which neighbor cell (if any) has to be probed given fractional position `f` in the cell
+    int
+    neighbor_offset(double f) const
+    {
+        if (f < this->radius)
+            return -1;
+        else if (f > 1. - this->radius)
+            return 1;
+        else
+            return 0;
+    }
+
+    bool
+    close(INT idx, double x, double y, double z) const
+    {
+        return std::abs(this->xs[idx] - x) <= this->tol &&
+               std::abs(this->ys[idx] - y) <= this->tol && std::abs(this->zs[idx] - z) <= this->tol;
+    }
+
+    INT
+    find(int64_t cx, int64_t cy, int64_t cz, double x, double y, double z) const
+    {
+        auto h = hash(cx, cy, cz);
+        auto tag = static_cast<uint32_t>(h >> 32);
+        for (auto pos = h & this->mask; this->slots[pos].idx != EMPTY;
+             pos = (pos + 1) & this->mask) {
+            const auto & s = this->slots[pos];
+            if (s.tag == tag && close(s.idx, x, y, z))
+                return s.idx;
+        }
+        return EMPTY;
+    }
+
+    void
+    rehash(std::size_t capacity)
+    {
+        std::vector<Slot> old(capacity, { 0, EMPTY });
+        std::swap(old, this->slots);
+        this->mask = capacity - 1;
+        for (const auto & s : old) {
+            if (s.idx == EMPTY)
+                continue;
+            auto h = hash(static_cast<int64_t>(std::floor(this->xs[s.idx] * this->inv_h)),
+                          static_cast<int64_t>(std::floor(this->ys[s.idx] * this->inv_h)),
+                          static_cast<int64_t>(std::floor(this->zs[s.idx] * this->inv_h)));
+            auto pos = h & this->mask;
+            while (this->slots[pos].idx != EMPTY)
+                pos = (pos + 1) & this->mask;
+            this->slots[pos] = s;
+        }
+    }
+
+    /// Cell width in multiples of the tolerance
+    static constexpr double CELL_FACTOR = 16.;
+    /// Initial number of hash slots (power of 2)
+    static constexpr std::size_t MIN_CAPACITY = 1024;
+    static constexpr INT EMPTY = -1;
+
+    /// Matching tolerance
+    double tol;
+    /// Inverse cell width
+    double inv_h;
+    /// Tolerance in units of cell width
+    double radius;
+    /// Hash table size - 1
+    std::size_t mask;
+    /// Number of nodes in the hash table
+    std::size_t n_hashed;
+    /// Hash table
+    std::vector<Slot> slots;
+    /// Coordinates of unique nodes
+    std::vector<double> xs, ys, zs;
+};
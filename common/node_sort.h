@@ -0,0 +1,106 @@
+// SPDX-FileCopyrightText: 2025 (c) David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "node_dedup.h"
+#include "snap_key.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+/// Bulk node numbering by sorting snapped coordinates
+///
+/// All points are snapped to a grid of spacing `tol`, the (snap key, position) records are sorted
+/// in parallel and points with identical snap keys are merged by a linear scan. Global IDs follow
+/// the sorted key order, so the numbering does not depend on the order of inputs or on the number
+/// of threads. Unlike `NodeDedup::insert()`, points are only merged when they snap to the same grid
+/// point, i.e. two points within `tol` that straddle a snapping boundary stay distinct.
+///
+/// @param pool Thread pool
+/// @param x x-coordinates of all points
+/// @param y y-coordinates of all points
+/// @param z z-coordinates of all points
+/// @param tol Snap tolerance
+/// @param nodes Unique nodes are appended here in global ID order
+/// @return Global 0-based ID of every point
+template <typename INT>
+inline std::vector<INT>
+sort_dedup(ThreadPool & pool,
+           const std::vector<double> & x,
+           const std::vector<double> & y,
+           const std::vector<double> & z,
+           double tol,
+           NodeDedup<INT> & nodes)
+{
+    struct Record {
+        int64_t kx, ky, kz;
+        uint64_t pos;
+
+        bool
+        operator<(const Record & other) const
+        {
+            return std::tie(this->kx, this->ky, this->kz, this->pos) <
+                   std::tie(other.kx, other.ky, other.kz, other.pos);
+        }
+    };
+
+    auto n = x.size();
+    double inv_tol = 1. / tol;
+    std::vector<Record> recs(n);
+    parallel_for(pool, n, [&](std::size_t begin, std::size_t end) {
+        for (auto i = begin; i < end; ++i)
+            recs[i] = { snap_key(x[i], inv_tol),
+                        snap_key(y[i], inv_tol),
+                        snap_key(z[i], inv_tol),
+                        i };
+    });
+
+    // sort runs in parallel, then merge them pairwise in parallel
+    std::size_t n_runs = std::max<std::size_t>(pool.size(), 1);
+    std::vector<std::size_t> bounds(n_runs + 1);
+    for (std::size_t r = 0; r <= n_runs; ++r)
+        bounds[r] = n * r / n_runs;
+    parallel_for(pool, n_runs, [&](std::size_t begin, std::size_t end) {
+        for (auto r = begin; r < end; ++r)
+            std::sort(recs.begin() + bounds[r], recs.begin() + bounds[r + 1]);
+    });
+    std::vector<Record> tmp(n);
+    while (bounds.size() > 2) {
+        std::size_t n_pairs = bounds.size() / 2;
+        parallel_for(pool, n_pairs, [&](std::size_t begin, std::size_t end) {
+            for (auto p = begin; p < end; ++p) {
+                auto lo = bounds[2 * p];
+                auto mid = bounds[2 * p + 1];
+                auto hi = 2 * p + 2 < bounds.size() ? bounds[2 * p + 2] : mid;
+                std::merge(recs.begin() + lo,
+                           recs.begin() + mid,
+                           recs.begin() + mid,
+                           recs.begin() + hi,
+                           tmp.begin() + lo);
+            }
+        });
+        std::swap(recs, tmp);
+        std::vector<std::size_t> merged;
+        for (std::size_t b = 0; b < bounds.size(); b += 2)
+            merged.push_back(bounds[b]);
+        if (merged.back() != n)
+            merged.push_back(n);
+        bounds = std::move(merged);
+    }
+
+    // merge duplicates, the first (lowest position) record of each key supplies the coordinates
+    std::vector<INT> ids(n);
+    nodes.reserve(nodes.size() + n, 0);
+    INT gid = -1;
+    for (std::size_t i = 0; i < n; ++i) {
+        const auto & r = recs[i];
+        if (i == 0 || r.kx != recs[i - 1].kx || r.ky != recs[i - 1].ky || r.kz != recs[i - 1].kz)
+            gid = nodes.append(x[r.pos], y[r.pos], z[r.pos]);
+        ids[r.pos] = gid;
+    }
+    return ids;
+}
@@ -0,0 +1,165 @@
+// SPDX-FileCopyrightText: 2025 (c) David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "reorder.h"
+#include "thread_pool.h"
+#include <fmt/core.h>
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+/// How points are assigned to parts
+enum class PartitionMethod {
+    /// Recursive coordinate bisection
+    RCB,
+    /// Contiguous ranges along the Hilbert space-filling curve
+    HILBERT,
+    /// Contiguous ranges along the Morton (Z-order) space-filling curve
+    MORTON
+};
+
+/// Convert string representation of a partitioning method into enum
+inline PartitionMethod
+partition_method(std::string_view str)
+{
+    if (str == "rcb")
+        return PartitionMethod::RCB;
+    else if (str == "hilbert")
+        return PartitionMethod::HILBERT;
+    else if (str == "morton")
+        return PartitionMethod::MORTON;
+    else
+        throw std::runtime_error(fmt::format("Unsupported partitioning method {}", str));
+}
+
+/// Partition points by recursive coordinate bisection
+///
+/// Every set of points is cut by a plane perpendicular to its longest extent, so that the two
+/// sides get numbers of points proportional to the numbers of parts they are split into further.
+/// Any number of parts works, not only powers of two. The cuts of one level of the recursion run
+/// in parallel on `pool`.
+///
+/// @param pool Thread pool
+/// @param x x-coordinates of points
+/// @param y y-coordinates of points
+/// @param z z-coordinates of points
+/// @param n_parts Number of parts
+/// @return Part (0-based) of every point
+inline std::vector<int>
+rcb_partition(ThreadPool & pool,
+              const std::vector<double> & x,
+              const std::vector<double> & y,
+              const std::vector<double> & z,
+              int n_parts)
+{
+    /// Points `idx[begin, end)` to be split into parts `first_part` and up
+    struct Segment {
+        std::size_t begin, end;
+        int first_part, n_parts;
+    };
+
+    const std::vector<double> * c[3] = { &x, &y, &z };
+    std::vector<std::size_t> idx(x.size());
+    std::iota(idx.begin(), idx.end(), 0);
+    std::vector<int> part(x.size());
+    std::vector<Segment> level = { { 0, x.size(), 0, n_parts } };
+    while (!level.empty()) {
+        std::vector<Segment> next(2 * level.size(), { 0, 0, 0, 0 });
+        parallel_for(pool, level.size(), [&](std::size_t s_begin, std::size_t s_end) {
+            for (std::size_t s = s_begin; s < s_end; ++s) {
+                auto seg = level[s];
+                if (seg.n_parts == 1) {
+                    for (auto i = seg.begin; i < seg.end; ++i)
+                        part[idx[i]] = seg.first_part;
+                    continue;
+                }
+
+                int axis = 0;
+                double longest = -1.;
+                for (int d = 0; d < 3; ++d) {
+                    auto [lo, hi] = std::minmax_element(
+                        idx.begin() + seg.begin,
+                        idx.begin() + seg.end,
+                        [&](std::size_t a, std::size_t b) { return (*c[d])[a] < (*c[d])[b]; });
+                    double extent = seg.begin < seg.end ? (*c[d])[*hi] - (*c[d])[*lo] : 0.;
+                    if (extent > longest) {
+                        longest = extent;
+                        axis = d;
+                    }
+                }
+
+                int n_left = seg.n_parts / 2;
+                auto mid = seg.begin + (seg.end - seg.begin) * n_left / seg.n_parts;
+                // ties go by index, so the cut does not depend on the order of `idx`
+                const auto & coord = *c[axis];
+                std::nth_element(idx.begin() + seg.begin,
+                                 idx.begin() + mid,
+                                 idx.begin() + seg.end,
+                                 [&](std::size_t a, std::size_t b) {
+                                     return coord[a] < coord[b] || (coord[a] == coord[b] && a < b);
+                                 });
+                next[2 * s] = { seg.begin, mid, seg.first_part, n_left };
+                next[2 * s + 1] = { mid, seg.end, seg.first_part + n_left, seg.n_parts - n_left };
+            }
+        });
+        level.clear();
+        for (auto & seg : next)
+            if (seg.n_parts > 0)
+                level.push_back(seg);
+    }
+    return part;
+}
+
+/// Partition points into contiguous ranges of equal size along a space-filling curve
+///
+/// @param method `PartitionMethod::HILBERT` or `PartitionMethod::MORTON`
+/// @param x x-coordinates of points
+/// @param y y-coordinates of points
+/// @param z z-coordinates of points
+/// @param n_parts Number of parts
+/// @return Part (0-based) of every point
+inline std::vector<int>
+sfc_partition(PartitionMethod method,
+              const std::vector<double> & x,
+              const std::vector<double> & y,
+              const std::vector<double> & z,
+              int n_parts)
+{
+    auto curve = method == PartitionMethod::HILBERT ? Reorder::HILBERT : Reorder::MORTON;
+    auto order = order_by_keys<std::size_t>(sfc_keys(curve, x, y, z));
+    std::vector<int> part(x.size());
+    auto n = static_cast<uint64_t>(order.size());
+    for (uint64_t k = 0; k < n; ++k)
+        part[order[k]] = static_cast<int>(k * n_parts / n);
+    return part;
+}
+
+/// Partition points
+///
+/// @param pool Thread pool
+/// @param method Partitioning method
+/// @param x x-coordinates of points
+/// @param y y-coordinates of points
+/// @param z z-coordinates of points
+/// @param n_parts Number of parts
+/// @return Part (0-based) of every point
+inline std::vector<int>
+partition(ThreadPool & pool,
+          PartitionMethod method,
+          const std::vector<double> & x,
+          const std::vector<double> & y,
+          const std::vector<double> & z,
+          int n_parts)
+{
+    if (n_parts < 1)
+        throw std::runtime_error(fmt::format("Cannot partition into {} parts", n_parts));
+    if (method == PartitionMethod::RCB)
+        return rcb_partition(pool, x, y, z, n_parts);
+    else
+        return sfc_partition(method, x, y, z, n_parts);
+}
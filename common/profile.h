@@ -0,0 +1,267 @@
+// SPDX-FileCopyrightText: 2025 (c) David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <fmt/core.h>
+#include <sys/resource.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+/// How a profile is printed
+enum class ProfileFormat {
+    /// Human-readable table
+    TABLE,
+    /// JSON object
+    JSON
+};
+
+/// Convert string representation of a profile format into enum
+inline ProfileFormat
+profile_format(std::string_view str)
+{
+    if (str == "table")
+        return ProfileFormat::TABLE;
+    else if (str == "json")
+        return ProfileFormat::JSON;
+    else
+        throw std::runtime_error(fmt::format("Unsupported profile format {}", str));
+}
+
+/// Wall time and data volume of the phases of a run
+///
+/// Phases are identified by name (a string literal) and reported in the order they were first
+/// seen. Phases timed on different threads can overlap, so their times need not add up to the
+/// total. Byte counts are the sizes of the arrays read and written, not what hit the disk.
+///
+/// All methods are thread-safe and do nothing until the profile is enabled.
+class Profile {
+public:
+    /// Adds its lifetime to the time of a phase
+    class Scope {
+    public:
+        Scope(Profile * prof, const char * phase) : prof(prof), phase(phase)
+        {
+            if (this->prof)
+                this->start = std::chrono::steady_clock::now();
+        }
+
+        ~Scope() { stop(); }
+
+        /// End the timing before the end of the scope
+        void
+        stop()
+        {
+            if (this->prof) {
+                std::chrono::duration<double> dt = std::chrono::steady_clock::now() - this->start;
+                this->prof->add_time(this->phase, dt.count());
+                this->prof = nullptr;
+            }
+        }
+
+        Scope(const Scope &) = delete;
+        Scope & operator=(const Scope &) = delete;
+
+    private:
+        Profile * prof;
+        const char * phase;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    /// Start profiling, the total wall time is measured from here
+    void
+    enable()
+    {
+        this->on = true;
+        this->start = std::chrono::steady_clock::now();
+    }
+
+    bool
+    enabled() const
+    {
+        return this->on;
+    }
+
+    /// Time a phase until the end of the enclosing scope
+    Scope
+    scope(const char * phase)
+    {
+        return Scope(this->on ? this : nullptr, phase);
+    }
+
+    /// Account data volume and processed items to a phase
+    ///
+    /// @param phase Phase name
+    /// @param bytes_read Bytes read
+    /// @param bytes_written Bytes written
+    /// @param items Number of items processed (nodes, entries, ...), reported as a rate
+    /// @param unit Name of the items
+    void
+    count(const char * phase,
+          uint64_t bytes_read,
+          uint64_t bytes_written = 0,
+          uint64_t items = 0,
+          const char * unit = nullptr)
+    {
+        if (!this->on)
+            return;
+        std::lock_guard<std::mutex> lock(this->mutex);
+        auto & ph = find(phase);
+        ph.bytes_read += bytes_read;
+        ph.bytes_written += bytes_written;
+        ph.items += items;
+        if (unit)
+            ph.unit = unit;
+    }
+
+    /// Print the profile
+    ///
+    /// @param format Output format
+    /// @param out Stream to print to
+    void
+    report(ProfileFormat format, std::FILE * out) const
+    {
+        if (!this->on)
+            return;
+        std::lock_guard<std::mutex> lock(this->mutex);
+        std::chrono::duration<double> total = std::chrono::steady_clock::now() - this->start;
+        if (format == ProfileFormat::JSON)
+            report_json(out, total.count());
+        else
+            report_table(out, total.count());
+    }
+
+    /// Peak resident set size of the process in bytes
+    static uint64_t
+    peak_rss()
+    {
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0)
+            return 0;
+#ifdef __APPLE__
+        return usage.ru_maxrss;
+#else
+        // kilobytes on Linux
+        return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+    }
+
+private:
+    struct Phase {
+        const char * name;
+        double seconds = 0;
+        uint64_t calls = 0;
+        uint64_t bytes_read = 0;
+        uint64_t bytes_written = 0;
+        uint64_t items = 0;
+        const char * unit = "items";
+
+        double
+        mb_per_s() const
+        {
+            auto bytes = this->bytes_read + this->bytes_written;
+            return this->seconds > 0 ? bytes / this->seconds / 1e6 : 0.;
+        }
+
+        double
+        items_per_s() const
+        {
+            return this->seconds > 0 ? this->items / this->seconds : 0.;
+        }
+    };
+
+    void
+    add_time(const char * phase, double seconds)
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        auto & ph = find(phase);
+        ph.seconds += seconds;
+        ph.calls++;
+    }
+
+    Phase &
+    find(const char * phase)
+    {
+        for (auto & ph : this->phases)
+            if (std::strcmp(ph.name, phase) == 0)
+                return ph;
+        this->phases.push_back(Phase { phase });
+        return this->phases.back();
+    }
+
+    void
+    report_table(std::FILE * out, double total) const
+    {
+        std::size_t wd = 5;
+        for (auto & ph : this->phases)
+            wd = std::max(wd, std::strlen(ph.name));
+        fmt::println(out, "");
+        fmt::println(out,
+                     "{:<{}}  {:>10} {:>8} {:>11} {:>12} {:>9}  {}",
+                     "Phase",
+                     wd,
+                     "Time [s]",
+                     "Calls",
+                     "Read [MB]",
+                     "Written [MB]",
+                     "MB/s",
+                     "Rate");
+        for (auto & ph : this->phases) {
+            fmt::print(out,
+                       "{:<{}}  {:>10.3f} {:>8} {:>11.1f} {:>12.1f} {:>9.1f}",
+                       ph.name,
+                       wd,
+                       ph.seconds,
+                       ph.calls,
+                       ph.bytes_read / 1e6,
+                       ph.bytes_written / 1e6,
+                       ph.mb_per_s());
+            if (ph.items > 0)
+                fmt::print(out, "  {:.3g} {}/s", ph.items_per_s(), ph.unit);
+            fmt::println(out, "");
+        }
+        fmt::println(out, "Total: {:.3f} s, peak RSS {:.1f} MB", total, peak_rss() / 1e6);
+    }
+
+    void
+    report_json(std::FILE * out, double total) const
+    {
+        fmt::print(out,
+                   "{{\"total_seconds\": {}, \"peak_rss_bytes\": {}, \"phases\": [",
+                   total,
+                   peak_rss());
+        for (std::size_t i = 0; i < this->phases.size(); ++i) {
+            auto & ph = this->phases[i];
+            fmt::print(out,
+                       "{}{{\"name\": \"{}\", \"seconds\": {}, \"calls\": {}, \"bytes_read\": {}, "
+                       "\"bytes_written\": {}, \"mb_per_s\": {}, \"items\": {}, \"unit\": \"{}\", "
+                       "\"items_per_s\": {}}}",
+                       i > 0 ? ", " : "",
+                       ph.name,
+                       ph.seconds,
+                       ph.calls,
+                       ph.bytes_read,
+                       ph.bytes_written,
+                       ph.mb_per_s(),
+                       ph.items,
+                       ph.unit,
+                       ph.items_per_s());
+        }
+        fmt::println(out, "]}}");
+    }
+
+    bool on = false;
+    std::chrono::steady_clock::time_point start;
+    mutable std::mutex mutex;
+    std::vector<Phase> phases;
+};
+
+/// Profile of this process
+inline Profile profile;
@@ -0,0 +1,233 @@
+// SPDX-FileCopyrightText: 2025 (c) David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <unistd.h>
+#include <fmt/core.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+
+/// How progress is reported
+enum class ProgressFormat {
+    /// Bar redrawn in place, for terminals
+    BAR,
+    /// One JSON object per line, for scripts and logs
+    JSON
+};
+
+/// Convert string representation of a progress format into enum
+///
+/// `auto` picks a bar when `out` is a terminal and JSON lines otherwise.
+inline ProgressFormat
+progress_format(std::string_view str, std::FILE * out = stderr)
+{
+    if (str == "auto")
+        return isatty(fileno(out)) ? ProgressFormat::BAR : ProgressFormat::JSON;
+    else if (str == "bar")
+        return ProgressFormat::BAR;
+    else if (str == "json")
+        return ProgressFormat::JSON;
+    else
+        throw std::runtime_error(fmt::format("Unsupported progress format {}", str));
+}
+
+/// Progress of the phases of a long run, reported periodically by a background thread
+///
+/// A run goes through phases one after another, each with a known amount of work (nodes, time
+/// steps, ...). Worker threads account what they finished with `advance()`, which only bumps
+/// relaxed atomic counters, and the reporter thread turns the counters into rates and an estimate
+/// of the remaining time. Until the progress is enabled, all methods return right away.
+class Progress {
+public:
+    ~Progress() { finish(); }
+
+    /// Start reporting
+    ///
+    /// @param format Output format
+    /// @param interval Seconds between reports
+    /// @param out Stream to report to
+    void
+    enable(ProgressFormat format, double interval, std::FILE * out = stderr)
+    {
+        if (this->on)
+            return;
+        if (!(interval > 0))
+            throw std::runtime_error("Progress interval must be positive");
+        this->format = format;
+        this->interval = std::chrono::duration<double>(interval);
+        this->out = out;
+        this->stop = false;
+        this->on = true;
+        this->reporter = std::thread([this] { run(); });
+    }
+
+    bool
+    enabled() const
+    {
+        return this->on;
+    }
+
+    /// Start a phase, ending the current one
+    ///
+    /// @param name Phase name (a string literal)
+    /// @param total Amount of work in the phase
+    /// @param unit Name of the units of work
+    void
+    phase(const char * name, uint64_t total, const char * unit)
+    {
+        if (!this->on)
+            return;
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (this->name)
+            print(true);
+        this->name = name;
+        this->total = total;
+        this->unit = unit;
+        this->done.store(0, std::memory_order_relaxed);
+        this->bytes.store(0, std::memory_order_relaxed);
+        this->start = std::chrono::steady_clock::now();
+    }
+
+    /// Account finished work to the current phase
+    ///
+    /// @param items Units of work finished
+    /// @param bytes Bytes read or written for them
+    void
+    advance(uint64_t items, uint64_t bytes = 0)
+    {
+        if (!this->on)
+            return;
+        this->done.fetch_add(items, std::memory_order_relaxed);
+        this->bytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    /// End the current phase and stop reporting
+    void
+    finish()
+    {
+        if (!this->on)
+            return;
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            if (this->name)
+                print(true);
+            this->name = nullptr;
+            this->stop = true;
+        }
+        this->wake.notify_all();
+        this->reporter.join();
+        this->on = false;
+    }
+
+private:
+    void
+    run()
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        while (!this->stop) {
+            this->wake.wait_for(lock, this->interval, [this] { return this->stop; });
+            if (!this->stop && this->name)
+                print(false);
+        }
+    }
+
+    /// Time left as `1h02m03s`, `2m03s` or `3s`
+    static std::string
+    format_eta(double seconds)
+    {
+        auto s = static_cast<uint64_t>(seconds + 0.5);
+        if (s >= 3600)
+            return fmt::format("{}h{:02}m{:02}s", s / 3600, s / 60 % 60, s % 60);
+        else if (s >= 60)
+            return fmt::format("{}m{:02}s", s / 60, s % 60);
+        else
+            return fmt::format("{}s", s);
+    }
+
+    /// Report the current phase, called with `mutex` held
+    ///
+    /// @param last This is the final report of the phase
+    void
+    print(bool last)
+    {
+        auto done = this->done.load(std::memory_order_relaxed);
+        auto bytes = this->bytes.load(std::memory_order_relaxed);
+        std::chrono::duration<double> dt = std::chrono::steady_clock::now() - this->start;
+        auto elapsed = dt.count();
+        double rate = elapsed > 0 ? done / elapsed : 0.;
+        double mb_per_s = elapsed > 0 ? bytes / elapsed / 1e6 : 0.;
+        // negative while the rate is not known yet
+        double eta = done >= this->total ? 0. : rate > 0 ? (this->total - done) / rate : -1.;
+        double fraction = this->total > 0 ? std::min(1., double(done) / this->total) : 1.;
+
+        if (this->format == ProgressFormat::JSON)
+            fmt::println(this->out,
+                         "{{\"phase\": \"{}\", \"done\": {}, \"total\": {}, \"unit\": \"{}\", "
+                         "\"elapsed_seconds\": {:.3f}, \"items_per_s\": {:.6g}, "
+                         "\"mb_per_s\": {:.6g}, \"eta_seconds\": {:.3f}, \"finished\": {}}}",
+                         this->name,
+                         done,
+                         this->total,
+                         this->unit,
+                         elapsed,
+                         rate,
+                         mb_per_s,
+                         eta,
+                         last);
+        else {
+            constexpr int WIDTH = 30;
+            int n = static_cast<int>(fraction * WIDTH);
+            std::string time;
+            if (last)
+                time = fmt::format(" in {}\n", format_eta(elapsed));
+            else if (eta >= 0)
+                time = fmt::format(" ETA {}", format_eta(eta));
+            // return to the start of the line and clear it
+            fmt::print(this->out,
+                       "\r\033[K{} [{:#<{}}{:.<{}}] {:3.0f}% {}/{} {} {:.3g} {}/s {:.1f} MB/s{}",
+                       this->name,
+                       "",
+                       n,
+                       "",
+                       WIDTH - n,
+                       100 * fraction,
+                       done,
+                       this->total,
+                       this->unit,
+                       rate,
+                       this->unit,
+                       mb_per_s,
+                       time);
+        }
+        std::fflush(this->out);
+    }
+
+    bool on = false;
+    ProgressFormat format = ProgressFormat::BAR;
+    std::chrono::duration<double> interval { 1. };
+    std::FILE * out = stderr;
+    std::thread reporter;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stop = false;
+    /// Current phase (`nullptr` if none)
+    const char * name = nullptr;
+    uint64_t total = 0;
+    const char * unit = "items";
+    std::chrono::steady_clock::time_point start;
+    std::atomic<uint64_t> done { 0 };
+    std::atomic<uint64_t> bytes { 0 };
+};
+
+/// Progress of this process
+inline Progress progress;
@@ -0,0 +1,358 @@
+// SPDX-FileCopyrightText: 2025 (c) David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "element_traits.h"
+#include <fmt/core.h>
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <numeric>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/// Mesh entity renumbering methods
+enum class Reorder {
+    /// Keep the original ordering
+    NONE,
+    /// Hilbert space-filling curve
+    HILBERT,
+    /// Morton (Z-order) space-filling curve
+    MORTON,
+    /// Reverse Cuthill-McKee
+    RCM
+};
+
+/// Convert string representation of a reordering method into enum
+inline Reorder
+reorder_method(std::string_view str)
+{
+    if (str == "none")
+        return Reorder::NONE;
+    else if (str == "hilbert")
+        return Reorder::HILBERT;
+    else if (str == "morton")
+        return Reorder::MORTON;
+    else if (str == "rcm")
+        return Reorder::RCM;
+    else
+        throw std::runtime_error(fmt::format("Unsupported reordering method {}", str));
+}
+
+namespace detail {
+
+/// Number of bits per axis in space-filling curve keys
+constexpr int SFC_BITS = 21;
+
+/// Interleave bits of the first `n` axes of `X` into a single key (most significant bits first)
+inline uint64_t
+interleave(const uint32_t X[3], int n)
+{
+    uint64_t key = 0;
+    for (int b = SFC_BITS - 1; b >= 0; --b)
+        for (int i = 0; i < n; ++i)
+            key = (key << 1) | ((X[i] >> b) & 1u);
+    return key;
+}
+
+/// Hilbert key of a point with integer coordinates `X` (modified in place) in `n` dimensions
+///
+/// Uses Skilling's transposition ("Programming the Hilbert curve", AIP Conf. Proc. 707, 2004).
+inline uint64_t
+hilbert_key(uint32_t X[3], int n)
+{
+    constexpr uint32_t M = 1u << (SFC_BITS - 1);
+    for (uint32_t Q = M; Q > 1; Q >>= 1) {
+        uint32_t P = Q - 1;
+        for (int i = 0; i < n; ++i) {
+            if (X[i] & Q)
+                X[0] ^= P;
+            else {
+                uint32_t t = (X[0] ^ X[i]) & P;
+                X[0] ^= t;
+                X[i] ^= t;
+            }
+        }
+    }
+    for (int i = 1; i < n; ++i)
+        X[i] ^= X[i - 1];
+    uint32_t t = 0;
+    for (uint32_t Q = M; Q > 1; Q >>= 1)
+        if (X[n - 1] & Q)
+            t ^= Q - 1;
+    for (int i = 0; i < n; ++i)
+        X[i] ^= t;
+    return interleave(X, n);
+}
+
+} // namespace detail
+
+/// Space-filling curve keys of points
+///
+/// Points are quantized on a `2^21` grid over their bounding box. If all points have the same
+/// z-coordinate, the 2D curve is used.
+///
+/// @param method `Reorder::HILBERT` or `Reorder::MORTON`
+/// @param x x-coordinates
+/// @param y y-coordinates
+/// @param z z-coordinates
+/// @return Key of every point
+inline std::vector<uint64_t>
+sfc_keys(Reorder method,
+         const std::vector<double> & x,
+         const std::vector<double> & y,
+         const std::vector<double> & z)
+{
+    const std::vector<double> * c[3] = { &x, &y, &z };
+    double lo[3], scale[3];
+    int n = 2;
+    for (int d = 0; d < 3; ++d) {
+        auto [mn, mx] = std::minmax_element(c[d]->begin(), c[d]->end());
+        lo[d] = c[d]->empty() ? 0. : *mn;
+        double extent = c[d]->empty() ? 0. : *mx - *mn;
+        scale[d] = extent > 0 ? ((1u << detail::SFC_BITS) - 1) / extent : 0.;
+        if (d == 2 && extent > 0)
+            n = 3;
+    }
+
+    std::vector<uint64_t> keys(x.size());
+    for (std::size_t i = 0; i < x.size(); ++i) {
+        uint32_t X[3];
+        for (int d = 0; d < 3; ++d)
+            X[d] = static_cast<uint32_t>(((*c[d])[i] - lo[d]) * scale[d]);
+        if (method == Reorder::HILBERT)
+            keys[i] = detail::hilbert_key(X, n);
+        else if (method == Reorder::MORTON)
+            keys[i] = detail::interleave(X, n);
+        else
+            throw std::runtime_error("Not a space-filling curve");
+    }
+    return keys;
+}
+
+/// Order of entities by increasing key (ties keep the original order)
+///
+/// @tparam INT Type of entity indices
+/// @return `order[k]` is the original index of the `k`-th entity
+template <typename INT = int, typename KEY>
+inline std::vector<INT>
+order_by_keys(const std::vector<KEY> & keys)
+{
+    std::vector<INT> order(keys.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&keys](INT a, INT b) {
+        return keys[a] < keys[b];
+    });
+    return order;
+}
+
+/// Reverse Cuthill-McKee ordering of mesh nodes
+///
+/// Two nodes are adjacent if they share an element. Each connected component is traversed
+/// breadth-first from its lowest-degree node, visiting neighbors in order of increasing degree,
+/// where degree is the number of elements attached to a node.
+///
+/// @param n_nodes Number of nodes
+/// @param block_connect Block ID -> connectivity array (1-based)
+/// @param num_nodes_per_elem Block ID -> number of nodes per element
+/// @return `order[k]` is the original index of the `k`-th node
+template <typename INT>
+inline std::vector<INT>
+rcm_order(std::size_t n_nodes,
+          const std::map<int64_t, std::vector<INT>> & block_connect,
+          const std::map<int64_t, int> & num_nodes_per_elem)
+{
+    // elements as (first node, number of nodes)
+    std::vector<std::pair<const INT *, int>> elems;
+    for (auto & [id, connect] : block_connect) {
+        auto nn = num_nodes_per_elem.at(id);
+        for (std::size_t i = 0; i + nn <= connect.size(); i += nn)
+            elems.emplace_back(connect.data() + i, nn);
+    }
+
+    // node -> element CSR (`nodes` are 1-based, so the counts end up shifted by one)
+    std::vector<std::size_t> offsets(n_nodes + 1, 0);
+    for (auto & [nodes, nn] : elems)
+        for (int j = 0; j < nn; ++j)
+            offsets[nodes[j]]++;
+    for (std::size_t i = 0; i < n_nodes; ++i)
+        offsets[i + 1] += offsets[i];
+    std::vector<std::size_t> node_elems(offsets[n_nodes]);
+    auto pos = offsets;
+    for (std::size_t e = 0; e < elems.size(); ++e)
+        for (int j = 0; j < elems[e].second; ++j)
+            node_elems[pos[elems[e].first[j] - 1]++] = e;
+    auto degree = [&offsets](INT n) {
+        return offsets[n + 1] - offsets[n];
+    };
+
+    std::vector<INT> by_degree(n_nodes);
+    std::iota(by_degree.begin(), by_degree.end(), 0);
+    std::stable_sort(by_degree.begin(), by_degree.end(), [&](INT a, INT b) {
+        return degree(a) < degree(b);
+    });
+
+    std::vector<INT> order;
+    order.reserve(n_nodes);
+    std::vector<char> visited(n_nodes, 0);
+    std::vector<INT> nbrs;
+    auto start = by_degree.begin();
+    while (order.size() < n_nodes) {
+        while (visited[*start])
+            ++start;
+        visited[*start] = 1;
+        order.push_back(*start);
+        // `order` doubles as the BFS queue
+        for (std::size_t head = order.size() - 1; head < order.size(); ++head) {
+            auto n = order[head];
+            nbrs.clear();
+            for (auto k = offsets[n]; k < offsets[n + 1]; ++k) {
+                auto & [nodes, nn] = elems[node_elems[k]];
+                for (int j = 0; j < nn; ++j) {
+                    auto m = nodes[j] - 1;
+                    if (!visited[m]) {
+                        visited[m] = 1;
+                        nbrs.push_back(m);
+                    }
+                }
+            }
+            std::stable_sort(nbrs.begin(), nbrs.end(), [&](INT a, INT b) {
+                return degree(a) < degree(b);
+            });
+            order.insert(order.end(), nbrs.begin(), nbrs.end());
+        }
+    }
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+namespace detail {
+
+/// Lowest node ID of every element of a block
+///
+/// @tparam NN Number of nodes per element
+template <int NN, typename INT>
+inline std::vector<INT>
+element_min_node(const std::vector<INT> & connect)
+{
+    auto n_elems = connect.size() / NN;
+    std::vector<INT> min_node(n_elems);
+    for (std::size_t e = 0; e < n_elems; ++e) {
+        const INT * elem = connect.data() + e * NN;
+        INT m = elem[0];
+        for (int j = 1; j < NN; ++j)
+            m = std::min(m, elem[j]);
+        min_node[e] = m;
+    }
+    return min_node;
+}
+
+/// Centroids of the elements of a block
+///
+/// @tparam NN Number of nodes per element
+template <int NN, typename INT>
+inline void
+element_centroids(const std::vector<INT> & connect,
+                  const std::vector<double> & x,
+                  const std::vector<double> & y,
+                  const std::vector<double> & z,
+                  std::vector<double> & cx,
+                  std::vector<double> & cy,
+                  std::vector<double> & cz)
+{
+    auto n_elems = connect.size() / NN;
+    cx.resize(n_elems);
+    cy.resize(n_elems);
+    cz.resize(n_elems);
+    for (std::size_t e = 0; e < n_elems; ++e) {
+        const INT * elem = connect.data() + e * NN;
+        double sx = 0., sy = 0., sz = 0.;
+        for (int j = 0; j < NN; ++j) {
+            auto n = elem[j] - 1;
+            sx += x[n];
+            sy += y[n];
+            sz += z[n];
+        }
+        cx[e] = sx / NN;
+        cy[e] = sy / NN;
+        cz[e] = sz / NN;
+    }
+}
+
+} // namespace detail
+
+/// Order of elements in a block
+///
+/// Space-filling curve methods order elements by the curve key of their centroid, RCM orders them
+/// by their lowest node ID, so it should be applied after nodes were renumbered.
+///
+/// @param method Reordering method
+/// @param connect Block connectivity (1-based)
+/// @param et Element type of the block
+/// @param x x-coordinates of nodes
+/// @param y y-coordinates of nodes
+/// @param z z-coordinates of nodes
+/// @return `order[k]` is the original index of the `k`-th element
+template <typename INT>
+inline std::vector<INT>
+element_order(Reorder method,
+              const std::vector<INT> & connect,
+              ElementType et,
+              const std::vector<double> & x,
+              const std::vector<double> & y,
+              const std::vector<double> & z)
+{
+    return dispatch(et, [&](auto traits) {
+        constexpr int NN = decltype(traits)::N_NODES;
+        if (method == Reorder::RCM)
+            return order_by_keys<INT>(detail::element_min_node<NN>(connect));
+        else {
+            std::vector<double> cx, cy, cz;
+            detail::element_centroids<NN>(connect, x, y, z, cx, cy, cz);
+            return order_by_keys<INT>(sfc_keys(method, cx, cy, cz));
+        }
+    });
+}
+
+/// Gather elements of a block: element `k` of `dest` is element `idx[k]` of `src`
+///
+/// @tparam NN Number of nodes per element
+/// @param src Connectivity to gather from
+/// @param idx Source element of every destination element
+/// @param dest Connectivity to gather into, at least `idx.size() * NN` entries
+template <int NN, typename INT, typename IDX>
+inline void
+gather_elements(const INT * src, const std::vector<IDX> & idx, INT * dest)
+{
+    for (std::size_t k = 0; k < idx.size(); ++k) {
+        const INT * s = src + static_cast<std::size_t>(idx[k]) * NN;
+        INT * d = dest + k * NN;
+        for (int j = 0; j < NN; ++j)
+            d[j] = s[j];
+    }
+}
+
+/// Scatter elements of a block: element `from[k]` of `src` becomes element `to[k]` of `dest`
+///
+/// @tparam NN Number of nodes per element
+/// @param src Connectivity to scatter from
+/// @param from Source elements
+/// @param to Destination elements
+/// @param dest Connectivity to scatter into
+template <int NN, typename INT, typename IDX>
+inline void
+scatter_elements(const INT * src,
+                 const std::vector<IDX> & from,
+                 const std::vector<IDX> & to,
+                 INT * dest)
+{
+    for (std::size_t k = 0; k < from.size(); ++k) {
+        const INT * s = src + static_cast<std::size_t>(from[k]) * NN;
+        INT * d = dest + static_cast<std::size_t>(to[k]) * NN;
+        for (int j = 0; j < NN; ++j)
+            d[j] = s[j];
+    }
+}
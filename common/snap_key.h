@@ -0,0 +1,40 @@
+// SPDX-FileCopyrightText: 2025 (c) David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <fmt/core.h>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+
+/// Largest magnitude of a snap key, leaving headroom below the range of `int64_t`
+constexpr double MAX_SNAP_KEY = 0x1p62;
+
+/// Check that coordinates snap to keys within `MAX_SNAP_KEY`
+///
+/// Beyond the range of `int64_t`, the result of `std::llround()` is unspecified, so points far
+/// apart could get the same key and be merged.
+///
+/// @param max_abs Largest magnitude of the coordinates
+/// @param tol Snap tolerance
+inline void
+check_snap_range(double max_abs, double tol)
+{
+    if (!(max_abs / tol < MAX_SNAP_KEY))
+        throw std::runtime_error(
+            fmt::format("Tolerance {:g} is too small for coordinates up to {:g}", tol, max_abs));
+}
+
+/// Index of the point of the tolerance grid nearest to a coordinate
+///
+/// @param v Coordinate
+/// @param inv_tol Inverse of the snap tolerance
+inline int64_t
+snap_key(double v, double inv_tol)
+{
+    auto k = v * inv_tol;
+    if (!(std::fabs(k) < MAX_SNAP_KEY))
+        check_snap_range(std::fabs(v), 1. / inv_tol);
+    return std::llround(k);
+}
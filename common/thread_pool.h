@@ -0,0 +1,224 @@
+// SPDX-FileCopyrightText: 2025 (c) David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/// Fixed-size pool of worker threads
+///
+/// With less than 2 threads, no workers are started and tasks run inline in `submit()`, so
+/// callers do not need a separate sequential code path.
+class ThreadPool {
+public:
+    /// @param n_threads Number of worker threads
+    explicit ThreadPool(unsigned int n_threads) : stopping(false)
+    {
+        if (n_threads > 1)
+            for (unsigned int i = 0; i < n_threads; ++i)
+                this->workers.emplace_back([this] { work(); });
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->stopping = true;
+        }
+        this->cv.notify_all();
+        for (auto & w : this->workers)
+            w.join();
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool & operator=(const ThreadPool &) = delete;
+
+    /// Number of worker threads (0 if tasks run inline)
+    std::size_t
+    size() const
+    {
+        return this->workers.size();
+    }
+
+    /// Schedule a task
+    ///
+    /// @param fn Callable to execute
+    /// @return Future holding the result of `fn` (or the exception it threw)
+    template <typename FN>
+    std::future<std::invoke_result_t<FN>>
+    submit(FN && fn)
+    {
+        using R = std::invoke_result_t<FN>;
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<FN>(fn));
+        auto future = task->get_future();
+        if (this->workers.empty())
+            (*task)();
+        else {
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                this->tasks.emplace([task] { (*task)(); });
+            }
+            this->cv.notify_one();
+        }
+        return future;
+    }
+
+private:
+    void
+    work()
+    {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                this->cv.wait(lock, [this] { return this->stopping || !this->tasks.empty(); });
+                if (this->stopping && this->tasks.empty())
+                    return;
+                task = std::move(this->tasks.front());
+                this->tasks.pop();
+            }
+            task();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stopping;
+};
+
+/// Single worker thread that runs tasks one at a time, in the order they were submitted
+class SerialQueue {
+public:
+    SerialQueue() : stopping(false), worker([this] { work(); }) {}
+
+    ~SerialQueue()
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->stopping = true;
+        }
+        this->cv.notify_all();
+        this->worker.join();
+    }
+
+    SerialQueue(const SerialQueue &) = delete;
+    SerialQueue & operator=(const SerialQueue &) = delete;
+
+    /// Schedule a task
+    ///
+    /// @param fn Callable to execute
+    /// @return Future holding the result of `fn` (or the exception it threw)
+    template <typename FN>
+    std::future<std::invoke_result_t<FN>>
+    submit(FN && fn)
+    {
+        using R = std::invoke_result_t<FN>;
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<FN>(fn));
+        auto future = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->tasks.emplace([task] { (*task)(); });
+        }
+        this->cv.notify_one();
+        return future;
+    }
+
+private:
+    void
+    work()
+    {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                this->cv.wait(lock, [this] { return this->stopping || !this->tasks.empty(); });
+                if (this->stopping && this->tasks.empty())
+                    return;
+                task = std::move(this->tasks.front());
+                this->tasks.pop();
+            }
+            task();
+        }
+    }
+
+    std::queue<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stopping;
+    /// Declared last, so it starts after the other members are initialized
+    std::thread worker;
+};
+
+/// Run `produce(i)` for `i` in `[0, n)` on `pool` and hand the results to `consume(i, result)` in
+/// order of `i` on the calling thread
+///
+/// At most `window` results are in flight at any time, which bounds the memory held by results
+/// that were produced but not consumed yet.
+///
+/// @param pool Thread pool to run `produce` on
+/// @param n Number of items
+/// @param window Maximum number of items in flight (at least 1)
+/// @param produce Callable `R(std::size_t)`
+/// @param consume Callable `void(std::size_t, R &&)`
+template <typename PRODUCE, typename CONSUME>
+void
+for_each_ordered(ThreadPool & pool,
+                 std::size_t n,
+                 std::size_t window,
+                 PRODUCE && produce,
+                 CONSUME && consume)
+{
+    using R = std::invoke_result_t<PRODUCE, std::size_t>;
+    std::deque<std::future<R>> in_flight;
+    std::size_t next = 0;
+    try {
+        for (std::size_t i = 0; i < n; ++i) {
+            for (; next < n && next < i + std::max<std::size_t>(window, 1); ++next)
+                in_flight.push_back(pool.submit([&produce, next] { return produce(next); }));
+            auto result = in_flight.front().get();
+            in_flight.pop_front();
+            consume(i, std::move(result));
+        }
+    }
+    catch (...) {
+        // tasks still in flight reference `produce`
+        for (auto & f : in_flight)
+            if (f.valid())
+                f.wait();
+        throw;
+    }
+}
+
+/// Split `[0, n)` into contiguous chunks and run `fn(begin, end)` on each of them on `pool`
+///
+/// @param pool Thread pool
+/// @param n Number of items
+/// @param fn Callable `void(std::size_t, std::size_t)`
+template <typename FN>
+void
+parallel_for(ThreadPool & pool, std::size_t n, FN && fn)
+{
+    std::size_t n_chunks = std::max<std::size_t>(pool.size(), 1);
+    std::vector<std::future<void>> chunks;
+    for (std::size_t c = 0; c < n_chunks; ++c) {
+        std::size_t begin = n * c / n_chunks;
+        std::size_t end = n * (c + 1) / n_chunks;
+        chunks.push_back(pool.submit([&fn, begin, end] { fn(begin, end); }));
+    }
+    for (auto & f : chunks)
+        f.wait();
+    for (auto & f : chunks)
+        f.get();
+}
@@ -0,0 +1,137 @@
+// SPDX-FileCopyrightText: 2025 (c) David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "exo_header.h"
+#include "io_lock.h"
+#include "join_map.h"
+#include "thread_pool.h"
+#include <exodusII.h>
+#include <fmt/core.h>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/// Time step of a run written in consecutive segments (e.g. restarts), and where it is read from
+struct StepSource {
+    /// Segment index
+    std::size_t segment;
+    /// Time step within the segment (1-based)
+    int step;
+    double time;
+};
+
+/// Read the time values of a file
+inline std::vector<double>
+read_time_values(const std::string & filename)
+{
+    auto lock = lock_io();
+    detail::ExoHandle exo(filename);
+    std::vector<double> times(ex_inquire_int(exo.exoid, EX_INQ_TIME));
+    if (!times.empty())
+        detail::check_ex(ex_get_all_times(exo.exoid, times.data()), "ex_get_all_times");
+    return times;
+}
+
+/// Hash of the contents of one time step of a file
+///
+/// Covers all nodal, element and global variables, so two steps with the same hash hold the same
+/// values for all practical purposes.
+///
+/// @param filename ExodusII file name
+/// @param hdr Header of the file
+/// @param step Time step (1-based)
+inline uint64_t
+step_hash(const std::string & filename, const ExoHeader & hdr, int step)
+{
+    auto lock = lock_io();
+    detail::ExoHandle exo(filename);
+    uint64_t h = 0;
+    std::vector<double> vals;
+    auto add = [&](ex_entity_type type, int var, int64_t id, int64_t n) {
+        vals.resize(n);
+        if (n > 0)
+            detail::check_ex(ex_get_var(exo.exoid, step, type, var, id, n, vals.data()),
+                             "ex_get_var");
+        h = hash_bytes(h, vals.data(), vals.size() * sizeof(double));
+    };
+    for (std::size_t v = 0; v < hdr.nodal_var_names.size(); ++v)
+        add(EX_NODAL, v + 1, 1, hdr.n_nodes);
+    auto n_elem_vars = hdr.elem_var_names.size();
+    auto truth = read_truth_table(exo.exoid, hdr);
+    for (std::size_t b = 0; b < hdr.blocks.size(); ++b)
+        for (std::size_t v = 0; v < n_elem_vars; ++v)
+            if (truth[b * n_elem_vars + v])
+                add(EX_ELEM_BLOCK, v + 1, hdr.blocks[b].id, hdr.blocks[b].n_elems);
+    if (!hdr.global_var_names.empty())
+        add(EX_GLOBAL, 1, 1, hdr.global_var_names.size());
+    return h;
+}
+
+/// Merge the time axes of the segments of a run into one
+///
+/// All inputs of a segment are parts of the same mesh and must have the same time steps. Segments
+/// follow each other in order, each with increasing times. A segment that starts before the
+/// previous ones end is a restart: it supersedes their steps after its first time. When it starts
+/// at a time that is already on the axis, that step is the one the run was restarted from, so it
+/// must hold the same values in both segments (compared by `step_hash()` of the first inputs), and
+/// it is taken from the earlier one.
+/// Every time is thus read and written only once.
+///
+/// @param pool Thread pool
+/// @param segments Segment -> input file names
+/// @param headers Segment -> headers of the input files
+/// @return Time steps of the run, in increasing order of time
+inline std::vector<StepSource>
+merge_time_axes(ThreadPool & pool,
+                const std::vector<std::vector<std::string>> & segments,
+                const std::vector<std::vector<ExoHeader>> & headers)
+{
+    std::vector<std::vector<std::future<std::vector<double>>>> pending(segments.size());
+    for (std::size_t s = 0; s < segments.size(); ++s)
+        for (auto & input : segments[s])
+            pending[s].push_back(pool.submit([&input] { return read_time_values(input); }));
+
+    std::vector<StepSource> axis;
+    for (std::size_t s = 0; s < segments.size(); ++s) {
+        std::vector<double> times;
+        for (std::size_t i = 0; i < segments[s].size(); ++i) {
+            auto part_times = pending[s][i].get();
+            if (i == 0)
+                times = std::move(part_times);
+            else if (part_times != times)
+                throw std::runtime_error(fmt::format("'{}' has different time steps than '{}'",
+                                                     segments[s][i],
+                                                     segments[s][0]));
+        }
+        // restarts are found by time, which needs a well-ordered axis
+        for (std::size_t k = 1; segments.size() > 1 && k < times.size(); ++k)
+            if (!(times[k - 1] < times[k]))
+                throw std::runtime_error(
+                    fmt::format("Time steps of '{}' are not increasing", segments[s][0]));
+
+        std::size_t first = 0;
+        if (!times.empty()) {
+            while (!axis.empty() && axis.back().time > times[0])
+                axis.pop_back();
+            if (!axis.empty() && axis.back().time == times[0]) {
+                auto & prev = axis.back();
+                auto prev_hash = step_hash(
+                    segments[prev.segment][0], headers[prev.segment][0], prev.step);
+                if (prev_hash != step_hash(segments[s][0], headers[s][0], 1))
+                    throw std::runtime_error(
+                        fmt::format("'{}' restarts at time {}, but its values there differ "
+                                    "from the ones in '{}'",
+                                    segments[s][0],
+                                    times[0],
+                                    segments[prev.segment][0]));
+                first = 1;
+            }
+        }
+        for (auto k = first; k < times.size(); ++k)
+            axis.push_back({ s, static_cast<int>(k + 1), times[k] });
+    }
+    return axis;
+}
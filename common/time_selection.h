@@ -0,0 +1,135 @@
+// SPDX-FileCopyrightText: 2025 (c) David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <fmt/core.h>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/// Which time steps of a file to process
+struct TimeSelection {
+    enum Kind {
+        /// All steps
+        ALL,
+        /// First step only
+        FIRST,
+        /// Last step only
+        LAST,
+        /// Every `n`-th step, starting with the first one
+        STRIDE,
+        /// Steps `first` through `last` (1-based, inclusive)
+        RANGE,
+        /// Steps of any of the selections in `list`
+        LIST
+    };
+
+    Kind kind = ALL;
+    int n = 1;
+    int first = 1;
+    int last = 1;
+    std::vector<TimeSelection> list;
+
+    /// Selected steps
+    ///
+    /// @param n_times Number of time steps in the inputs
+    /// @return Indices of selected steps (1-based), ascending
+    std::vector<int>
+    steps(int n_times) const
+    {
+        std::vector<int> steps;
+        if (this->kind == ALL || this->kind == STRIDE) {
+            for (int t = 1; t <= n_times; t += this->n)
+                steps.push_back(t);
+        }
+        else if (this->kind == FIRST) {
+            if (n_times > 0)
+                steps.push_back(1);
+        }
+        else if (this->kind == LAST) {
+            if (n_times > 0)
+                steps.push_back(n_times);
+        }
+        else if (this->kind == LIST) {
+            for (auto & sel : this->list) {
+                auto sel_steps = sel.steps(n_times);
+                steps.insert(steps.end(), sel_steps.begin(), sel_steps.end());
+            }
+            std::sort(steps.begin(), steps.end());
+            steps.erase(std::unique(steps.begin(), steps.end()), steps.end());
+        }
+        else {
+            if (this->last > n_times)
+                throw std::runtime_error(
+                    fmt::format("Time step range ends at {}, but there are only {} steps",
+                                this->last,
+                                n_times));
+            for (int t = this->first; t <= this->last; ++t)
+                steps.push_back(t);
+        }
+        return steps;
+    }
+};
+
+/// Parse a time step selection: `all`, `first`, `last`, `stride:N`, `range:A:B`, a step `N`, or
+/// a comma-separated list of those (e.g. `first,5,range:10:20,last`)
+inline TimeSelection
+time_selection(const std::string & str)
+{
+    TimeSelection sel;
+    auto parse_int = [&str](const std::string & val) {
+        std::size_t pos = 0;
+        int i = -1;
+        try {
+            i = std::stoi(val, &pos);
+        }
+        catch (std::exception &) {
+            pos = 0;
+        }
+        if (pos != val.size() || i < 1)
+            throw std::runtime_error(fmt::format("Invalid time step selection '{}'", str));
+        return i;
+    };
+
+    if (str.find(',') != std::string::npos) {
+        sel.kind = TimeSelection::LIST;
+        std::size_t start = 0;
+        while (true) {
+            auto comma = str.find(',', start);
+            auto item = str.substr(start, comma == std::string::npos ? comma : comma - start);
+            if (item.empty())
+                throw std::runtime_error(fmt::format("Invalid time step selection '{}'", str));
+            sel.list.push_back(time_selection(item));
+            if (comma == std::string::npos)
+                break;
+            start = comma + 1;
+        }
+    }
+    else if (str == "all")
+        sel.kind = TimeSelection::ALL;
+    else if (str == "first")
+        sel.kind = TimeSelection::FIRST;
+    else if (str == "last")
+        sel.kind = TimeSelection::LAST;
+    else if (str.rfind("stride:", 0) == 0) {
+        sel.kind = TimeSelection::STRIDE;
+        sel.n = parse_int(str.substr(7));
+    }
+    else if (str.rfind("range:", 0) == 0) {
+        auto colon = str.find(':', 6);
+        if (colon == std::string::npos)
+            throw std::runtime_error(fmt::format("Invalid time step selection '{}'", str));
+        sel.kind = TimeSelection::RANGE;
+        sel.first = parse_int(str.substr(6, colon - 6));
+        sel.last = parse_int(str.substr(colon + 1));
+        if (sel.first > sel.last)
+            throw std::runtime_error(fmt::format("Invalid time step selection '{}'", str));
+    }
+    else {
+        sel.kind = TimeSelection::RANGE;
+        sel.first = sel.last = parse_int(str);
+    }
+    return sel;
+}
@@ -0,0 +1,293 @@
+// SPDX-FileCopyrightText: 2025 (c) David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "binary_io.h"
+#include "exo_header.h"
+#include "io_lock.h"
+#include "kernels.h"
+#include "thread_pool.h"
+#include <exodusII.h>
+#include <fmt/core.h>
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+/// Kind of a variable
+enum class VarKind : char {
+    //
+    NODAL = 'n',
+    ELEMENT = 'e'
+};
+
+/// One variable at one time step
+struct StatsKey {
+    VarKind kind;
+    std::string name;
+    /// Time step (1-based)
+    int step;
+
+    bool
+    operator<(const StatsKey & other) const
+    {
+        return std::tie(this->kind, this->name, this->step) <
+               std::tie(other.kind, other.name, other.step);
+    }
+};
+
+/// Statistics of a variable at one time step
+struct StepStats {
+    double time;
+    Moments moments;
+};
+
+/// Keys of the requested variables at the requested time steps
+///
+/// @param hdr File header
+/// @param names Variable names, all nodal and element variables if empty
+/// @param steps Time steps (1-based)
+inline std::vector<StatsKey>
+stats_keys(const ExoHeader & hdr,
+           const std::vector<std::string> & names,
+           const std::vector<int> & steps)
+{
+    std::vector<std::pair<VarKind, std::string>> vars;
+    if (names.empty()) {
+        for (auto & name : hdr.nodal_var_names)
+            vars.emplace_back(VarKind::NODAL, name);
+        for (auto & name : hdr.elem_var_names)
+            vars.emplace_back(VarKind::ELEMENT, name);
+    }
+    for (auto & name : names) {
+        auto has = [&](const std::vector<std::string> & all) {
+            return std::find(all.begin(), all.end(), name) != all.end();
+        };
+        if (has(hdr.nodal_var_names))
+            vars.emplace_back(VarKind::NODAL, name);
+        else if (has(hdr.elem_var_names))
+            vars.emplace_back(VarKind::ELEMENT, name);
+        else
+            throw std::runtime_error(fmt::format("Unknown nodal or element variable '{}'", name));
+    }
+
+    std::vector<StatsKey> keys;
+    for (auto & [kind, name] : vars)
+        for (auto s : steps)
+            keys.push_back({ kind, name, s });
+    return keys;
+}
+
+/// Compute statistics of variables of a file
+///
+/// Values are read one array at a time (a nodal variable, or an element variable in one block),
+/// the next array while the current one is reduced on `pool`. So no more than two arrays are held
+/// in memory, whatever the number of variables and steps.
+///
+/// @param filename ExodusII file name
+/// @param hdr Header of the file
+/// @param keys Variables and steps to compute
+/// @param pool Thread pool for the reductions
+/// @return Statistics of every key
+inline std::map<StatsKey, StepStats>
+compute_var_stats(const std::string & filename,
+                  const ExoHeader & hdr,
+                  const std::vector<StatsKey> & keys,
+                  ThreadPool & pool)
+{
+    // arrays smaller than this are not worth splitting between threads
+    constexpr std::size_t MIN_PARALLEL = 1 << 16;
+
+    std::map<StatsKey, StepStats> stats;
+    if (keys.empty())
+        return stats;
+
+    auto lock = lock_io();
+    detail::ExoHandle exo(filename);
+    std::vector<double> times(hdr.n_times);
+    if (hdr.n_times > 0)
+        detail::check_ex(ex_get_all_times(exo.exoid, times.data()), "ex_get_all_times");
+    auto n_blocks = hdr.blocks.size();
+    auto n_elem_vars = hdr.elem_var_names.size();
+    auto truth = read_truth_table(exo.exoid, hdr);
+    lock.unlock();
+
+    struct Read {
+        std::size_t key;
+        ex_entity_type type;
+        /// Variable index (1-based)
+        int var;
+        int64_t blk_id;
+        int64_t n;
+    };
+    std::vector<Read> reads;
+    auto index_of = [](const std::vector<std::string> & names, const std::string & name) {
+        return static_cast<int>(std::find(names.begin(), names.end(), name) - names.begin());
+    };
+    for (std::size_t k = 0; k < keys.size(); ++k) {
+        auto & key = keys[k];
+        stats[key] = { times.at(key.step - 1), Moments() };
+        if (key.kind == VarKind::NODAL)
+            reads.push_back({ k, EX_NODAL, index_of(hdr.nodal_var_names, key.name) + 1, 1,
+                              hdr.n_nodes });
+        else {
+            auto v = index_of(hdr.elem_var_names, key.name);
+            for (std::size_t b = 0; b < n_blocks; ++b)
+                if (truth[b * n_elem_vars + v] && hdr.blocks[b].n_elems > 0)
+                    reads.push_back({ k, EX_ELEM_BLOCK, v + 1, hdr.blocks[b].id,
+                                      hdr.blocks[b].n_elems });
+        }
+    }
+
+    std::vector<double> current, next;
+    // declared after the buffers, so pending reads finish before the buffers go away
+    SerialQueue reader;
+    auto read = [&](const Read & r) {
+        next.resize(r.n);
+        auto lock = lock_io();
+        detail::check_ex(
+            ex_get_var(exo.exoid, keys[r.key].step, r.type, r.var, r.blk_id, r.n, next.data()),
+            "ex_get_var");
+    };
+    std::future<void> pending;
+    try {
+        if (!reads.empty())
+            pending = reader.submit([&] { read(reads[0]); });
+        for (std::size_t k = 0; k < reads.size(); ++k) {
+            pending.get();
+            std::swap(current, next);
+            if (k + 1 < reads.size())
+                pending = reader.submit([&, k] { read(reads[k + 1]); });
+
+            auto & m = stats[keys[reads[k].key]].moments;
+            if (current.size() < MIN_PARALLEL || pool.size() < 2)
+                m.merge(moments(current.data(), current.size()));
+            else {
+                std::mutex mutex;
+                parallel_for(pool, current.size(), [&](std::size_t begin, std::size_t end) {
+                    auto part = moments(current.data() + begin, end - begin);
+                    std::lock_guard<std::mutex> guard(mutex);
+                    m.merge(part);
+                });
+            }
+        }
+    }
+    catch (...) {
+        if (pending.valid())
+            pending.wait();
+        // the file is closed under the lock
+        lock.lock();
+        throw;
+    }
+    lock.lock();
+    return stats;
+}
+
+/// Name of the statistics cache saved next to a file
+inline std::string
+stats_cache_filename(const std::string & filename)
+{
+    return filename + ".stats";
+}
+
+/// Variable statistics cached next to a file
+///
+/// The cache is only valid for the file contents it was computed from, which is told by the
+/// modification time and the size of the file. A stale, missing or damaged cache is treated as
+/// empty. The binary format uses the native byte order.
+class StatsCache {
+public:
+    /// Load the cache of a file
+    ///
+    /// @param filename ExodusII file name
+    explicit StatsCache(const std::string & filename) :
+        filename(stats_cache_filename(filename)),
+        mtime(std::filesystem::last_write_time(filename).time_since_epoch().count()),
+        size(std::filesystem::file_size(filename)),
+        dirty(false)
+    {
+        try {
+            load();
+        }
+        catch (std::exception &) {
+            this->entries.clear();
+        }
+    }
+
+    /// Cached statistics, `nullptr` if not cached
+    const StepStats *
+    find(const StatsKey & key) const
+    {
+        auto it = this->entries.find(key);
+        return it != this->entries.end() ? &it->second : nullptr;
+    }
+
+    void
+    insert(const StatsKey & key, const StepStats & stats)
+    {
+        this->entries[key] = stats;
+        this->dirty = true;
+    }
+
+    /// Write the cache if anything was added, replacing the file with `detail::replace_file()`
+    ///
+    /// @return `false` if the cache could not be written (e.g. read-only directory)
+    bool
+    save()
+    {
+        if (!this->dirty)
+            return true;
+        auto written = detail::replace_file(this->filename, [&](std::ofstream & os) {
+            detail::write_magic(os, MAGIC);
+            detail::write_pod(os, this->mtime);
+            detail::write_pod(os, this->size);
+            detail::write_pod<uint64_t>(os, this->entries.size());
+            for (auto & [key, stats] : this->entries) {
+                detail::write_pod(os, key.kind);
+                detail::write_pod<int32_t>(os, key.step);
+                detail::write_pod<uint32_t>(os, key.name.size());
+                os.write(key.name.data(), key.name.size());
+                detail::write_pod(os, stats);
+            }
+        });
+        if (written)
+            this->dirty = false;
+        return written;
+    }
+
+private:
+    static constexpr detail::FileMagic MAGIC = { 'E', 'X', 'S', 'T', 'A', 'T', '0', '1' };
+
+    void
+    load()
+    {
+        std::ifstream is(this->filename, std::ios::binary);
+        if (!is || !detail::read_magic(is, MAGIC))
+            return;
+        if (detail::read_pod<int64_t>(is) != this->mtime ||
+            detail::read_pod<uint64_t>(is) != this->size)
+            return;
+        auto n = detail::read_pod<uint64_t>(is);
+        for (uint64_t i = 0; i < n; ++i) {
+            StatsKey key;
+            key.kind = detail::read_pod<VarKind>(is);
+            key.step = detail::read_pod<int32_t>(is);
+            key.name.resize(detail::read_pod<uint32_t>(is));
+            is.read(key.name.data(), key.name.size());
+            this->entries[key] = detail::read_pod<StepStats>(is);
+        }
+    }
+
+    std::string filename;
+    int64_t mtime;
+    uint64_t size;
+    std::map<StatsKey, StepStats> entries;
+    bool dirty;
+};
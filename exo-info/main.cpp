@@ -3,14 +3,21 @@
 
 #include <cstdlib>
 #include "common.h"
+#include "exo_header.h"
+#include "io_lock.h"
+#include "profile.h"
+#include "thread_pool.h"
+#include "time_selection.h"
+#include "var_stats.h"
 #include "cxxopts/cxxopts.hpp"
-#include <exodusIIcpp/exodusIIcpp.h>
 #include <fmt/core.h>
+#include <glob.h>
+#include <map>
 
 void
-print_cell_set_info(const exodusIIcpp::File & exo)
+print_cell_set_info(const ExoHeader & hdr)
 {
-    const auto & blocks = exo.get_element_blocks();
+    const auto & blocks = hdr.blocks;
     if (blocks.size() > 0) {
         fmt::print("\n");
         fmt::print("Cell sets [{}]:\n", blocks.size());
@@ -18,30 +25,29 @@ print_cell_set_info(const exodusIIcpp::File & exo)
         std::size_t wd_name = 1;
         std::size_t wd_num = 1;
         for (const auto & eb : blocks) {
-            wd_id = std::max(wd_id, fmt::format("{}", eb.get_id()).size());
-            auto name = eb.get_name();
+            wd_id = std::max(wd_id, fmt::format("{}", eb.id).size());
+            auto name = eb.name;
             if (name.size() == 0)
                 name = "<no name>";
             wd_name = std::max(wd_name, fmt::format("{}", name).size());
-            wd_num =
-                std::max(wd_num, fmt::format("{}", human_number(eb.get_num_elements())).size());
+            wd_num = std::max(wd_num, fmt::format("{}", human_number(eb.n_elems)).size());
         }
         wd_name++;
 
         for (const auto & eb : blocks) {
             // auto elem_counts = element_counts(mesh, id);
-            auto id = eb.get_id();
+            auto id = eb.id;
 
             fmt::print("- {:>{}}: ", id, wd_id);
 
-            auto name = eb.get_name();
+            auto name = eb.name;
             if (name.size() == 0)
                 name = "<no name>";
             fmt::print("{:<{}} ", name, wd_name);
 
-            fmt::print("{:>{}} elements ", human_number(eb.get_num_elements()), wd_num);
+            fmt::print("{:>{}} elements ", human_number(eb.n_elems), wd_num);
             fmt::print(" (");
-            auto etyp = element_type(eb.get_element_type());
+            auto etyp = element_type(eb.element_type);
             fmt::print("{}", element_type_str(etyp));
             fmt::print(")");
             fmt::print("\n");
@@ -50,74 +56,322 @@ print_cell_set_info(const exodusIIcpp::File & exo)
 }
 
 void
-print_side_set_info(const exodusIIcpp::File & exo)
+print_side_set_info(const ExoHeader & hdr)
 {
     // side sets
-    if (exo.get_num_side_sets() > 0) {
+    if (hdr.side_sets.size() > 0) {
         std::size_t wd_id = 1;
         std::size_t wd_name = 1;
         std::size_t wd_num = 1;
-        for (const auto & ss : exo.get_side_sets()) {
-            wd_id = std::max(wd_id, fmt::format("{}", ss.get_id()).size());
-            auto name = ss.get_name();
+        for (const auto & ss : hdr.side_sets) {
+            wd_id = std::max(wd_id, fmt::format("{}", ss.id).size());
+            auto name = ss.name;
             if (name.size() == 0)
                 name = "<no name>";
             wd_name = std::max(wd_name, fmt::format("{}", name).size());
-            wd_num = std::max(wd_num, fmt::format("{}", human_number(ss.get_size())).size());
+            wd_num = std::max(wd_num, fmt::format("{}", human_number(ss.size)).size());
         }
         wd_name++;
 
         fmt::print("\n");
-        fmt::print("Side sets [{}]:\n", exo.get_num_side_sets());
+        fmt::print("Side sets [{}]:\n", hdr.side_sets.size());
 
-        for (const auto & ss : exo.get_side_sets()) {
-            auto id = ss.get_id();
+        for (const auto & ss : hdr.side_sets) {
+            auto id = ss.id;
             fmt::print("- {:>{}}: ", id, wd_id);
-            auto name = ss.get_name();
+            auto name = ss.name;
             if (name.size() == 0)
                 name = "<no name>";
             fmt::print("{:<{}} ", name, wd_name);
 
-            fmt::print("{:>{}} sides\n", human_number(ss.get_size()), wd_num);
+            fmt::print("{:>{}} sides\n", human_number(ss.size), wd_num);
         }
     }
 }
 
+void
+print_variable_info(const char * title, const std::vector<std::string> & names)
+{
+    if (names.size() > 0) {
+        fmt::print("\n");
+        fmt::print("{} [{}]:\n", title, names.size());
+        for (const auto & name : names)
+            fmt::print("- {}\n", name);
+    }
+}
+
+void
+print_mesh_info(const ExoHeader & hdr)
+{
+    fmt::print("\n");
+    fmt::print("Global:\n");
+    fmt::print("- {} elements\n", human_number(hdr.n_elems));
+    fmt::print("- {} nodes\n", human_number(hdr.n_nodes));
+    fmt::print("- {} time steps\n", human_number(hdr.n_times));
+
+    print_cell_set_info(hdr);
+    print_side_set_info(hdr);
+    print_variable_info("Nodal variables", hdr.nodal_var_names);
+    print_variable_info("Element variables", hdr.elem_var_names);
+    print_variable_info("Global variables", hdr.global_var_names);
+}
+
 void
 print_mesh_info(const std::string & filename)
 {
     fmt::print("Reading file: {}...", filename);
     std::fflush(stdout);
-    exodusIIcpp::File exo(filename, exodusIIcpp::FileAccess::READ);
-    exo.read_blocks();
-    exo.read_side_sets();
+    // only the header is needed, bulk data is never read
+    auto timer = profile.scope("read headers");
+    auto hdr = read_header(filename);
+    timer.stop();
+    profile.count("read headers", 0, 0, 1, "files");
     fmt::print(" done\n");
+    print_mesh_info(hdr);
+}
+
+/// Print totals over many files and the differences between them
+void
+print_summary(const std::vector<ExoHeader> & hdrs)
+{
+    int64_t n_elems = 0;
+    int64_t n_nodes = 0;
+    // block ID -> number of files that have it
+    std::map<int64_t, std::size_t> block_count;
+    // number of time steps -> number of files
+    std::map<int, std::size_t> time_count;
+    for (const auto & hdr : hdrs) {
+        n_elems += hdr.n_elems;
+        n_nodes += hdr.n_nodes;
+        for (const auto & eb : hdr.blocks)
+            block_count[eb.id]++;
+        time_count[hdr.n_times]++;
+    }
 
     fmt::print("\n");
-    fmt::print("Global:\n");
-    fmt::print("- {} elements\n", human_number(exo.get_num_elements()));
-    fmt::print("- {} nodes\n", human_number(exo.get_num_nodes()));
+    fmt::print("Summary [{} files]:\n", hdrs.size());
+    fmt::print("- {} elements\n", human_number(n_elems));
+    fmt::print("- {} nodes\n", human_number(n_nodes));
+    fmt::print("- {} blocks\n", block_count.size());
+    for (auto & [id, cnt] : block_count)
+        if (cnt != hdrs.size())
+            fmt::print("  - block {} present in {} of {} files\n", id, cnt, hdrs.size());
+    if (time_count.size() == 1)
+        fmt::print("- {} time steps\n", human_number(time_count.begin()->first));
+    else {
+        fmt::print("- mismatched number of time steps:\n");
+        for (auto & [n_times, cnt] : time_count)
+            fmt::print("  - {} time steps in {} files\n", human_number(n_times), cnt);
+    }
+}
 
-    print_cell_set_info(exo);
-    print_side_set_info(exo);
+/// Variables and time steps to compute statistics of
+struct StatsOptions {
+    /// Variable names, all nodal and element variables if empty
+    std::vector<std::string> vars;
+    /// Time steps
+    TimeSelection times;
+};
+
+/// Print statistics of one variable over the selected time steps
+void
+print_var_stats(const std::vector<StatsKey> & keys, const std::map<StatsKey, StepStats> & stats)
+{
+    auto & first = keys.front();
+    fmt::print("\n");
+    fmt::print("{} variable {}:\n",
+               first.kind == VarKind::NODAL ? "Nodal" : "Element",
+               first.name);
+    fmt::print(
+        "{:>6} {:>13} {:>13} {:>13} {:>13} {:>13}\n", "step", "time", "min", "max", "mean", "L2");
+    for (auto & key : keys) {
+        auto & st = stats.at(key);
+        auto & m = st.moments;
+        if (m.n == 0)
+            fmt::print("{:>6} {:>13.6g} {:>13} {:>13} {:>13} {:>13}\n",
+                       key.step,
+                       st.time,
+                       "-",
+                       "-",
+                       "-",
+                       "-");
+        else
+            fmt::print("{:>6} {:>13.6g} {:>13.6g} {:>13.6g} {:>13.6g} {:>13.6g}\n",
+                       key.step,
+                       st.time,
+                       m.min,
+                       m.max,
+                       m.mean(),
+                       m.l2());
+    }
+}
+
+/// Print statistics of variables of a file
+///
+/// Statistics are taken from the file's cache where possible, the rest is computed and added to
+/// the cache.
+void
+print_stats(const std::string & filename, const StatsOptions & opts, ThreadPool & pool)
+{
+    auto hdr_timer = profile.scope("read headers");
+    ExoHeader hdr;
+    {
+        auto lock = lock_io();
+        hdr = read_header(filename);
+    }
+    profile.count("read headers", 0, 0, 1, "files");
+    hdr_timer.stop();
+    auto steps = opts.times.steps(hdr.n_times);
+    auto keys = stats_keys(hdr, opts.vars, steps);
+
+    StatsCache cache(filename);
+    std::map<StatsKey, StepStats> stats;
+    std::vector<StatsKey> missing;
+    for (auto & key : keys) {
+        if (auto * st = cache.find(key))
+            stats[key] = *st;
+        else
+            missing.push_back(key);
+    }
+    profile.count("statistics cache", 0, 0, keys.size() - missing.size(), "hits");
+    if (!missing.empty()) {
+        auto timer = profile.scope("statistics");
+        for (auto & [key, st] : compute_var_stats(filename, hdr, missing, pool)) {
+            profile.count("statistics", st.moments.n * sizeof(double), 0, st.moments.n, "values");
+            cache.insert(key, st);
+            stats[key] = st;
+        }
+        timer.stop();
+        cache.save();
+    }
+
+    // keys go variable by variable, each with all selected steps
+    for (std::size_t begin = 0; begin < keys.size(); begin += steps.size())
+        print_var_stats({ keys.begin() + begin, keys.begin() + begin + steps.size() }, stats);
+}
+
+/// Expand shell-style wildcards in file names (for lists too long for the command line)
+std::vector<std::string>
+expand_globs(const std::vector<std::string> & patterns)
+{
+    std::vector<std::string> filenames;
+    for (const auto & pat : patterns) {
+        if (pat.find_first_of("*?[") == std::string::npos) {
+            filenames.push_back(pat);
+            continue;
+        }
+        glob_t g;
+        if (glob(pat.c_str(), 0, nullptr, &g) == 0)
+            filenames.insert(filenames.end(), g.gl_pathv, g.gl_pathv + g.gl_pathc);
+        else
+            filenames.push_back(pat);
+        globfree(&g);
+    }
+    return filenames;
+}
+
+/// Print information about many files, reading headers on `n_jobs` threads
+///
+/// @return `true` if all files were read successfully
+bool
+print_batch_info(const std::vector<std::string> & filenames, unsigned int n_jobs)
+{
+    struct Result {
+        ExoHeader hdr;
+        std::string error;
+    };
+
+    ThreadPool pool(n_jobs);
+    std::vector<ExoHeader> hdrs;
+    bool ok = true;
+    for_each_ordered(
+        pool,
+        filenames.size(),
+        std::max<std::size_t>(2 * pool.size(), 1),
+        [&](std::size_t i) {
+            Result res;
+            auto timer = profile.scope("read headers");
+            try {
+                auto lock = lock_io();
+                res.hdr = read_header(filenames[i]);
+                profile.count("read headers", 0, 0, 1, "files");
+            }
+            catch (std::exception & e) {
+                res.error = e.what();
+            }
+            return res;
+        },
+        [&](std::size_t i, Result && res) {
+            auto timer = profile.scope("print");
+            if (i > 0)
+                fmt::print("\n");
+            fmt::print("File: {}\n", filenames[i]);
+            if (res.error.empty()) {
+                print_mesh_info(res.hdr);
+                hdrs.push_back(std::move(res.hdr));
+            }
+            else {
+                fmt::print("ERROR: {}\n", res.error);
+                ok = false;
+            }
+        });
+    if (hdrs.size() > 1)
+        print_summary(hdrs);
+    return ok;
 }
 
 int
 main(int argc, char * argv[])
 {
     try {
-        cxxopts::Options options("exo-info", "Display information about an exodusII file");
+        cxxopts::Options options("exo-info", "Display information about exodusII files");
         // clang-format off
         options.add_options()
-            ("filename", "The mesh file name", cxxopts::value<std::string>())
+            ("filenames", "The mesh file names", cxxopts::value<std::vector<std::string>>())
+            ("j,jobs", "Number of threads reading files",
+                cxxopts::value<unsigned int>()->default_value("1"))
+            ("stats", "Print min/max/mean/L2 of variables instead of the mesh summary")
+            ("vars", "Variables for --stats (default: all nodal and element variables)",
+                cxxopts::value<std::vector<std::string>>())
+            ("times", "Time steps for --stats [all, first, last, stride:N, range:A:B, N], "
+                "comma-separated", cxxopts::value<std::string>()->default_value("all"))
+            ("profile", "Print phase timings to stderr [table, json]",
+                cxxopts::value<std::string>()->implicit_value("table"))
             ("h,help", "Print usage")
         ;
         // clang-format on
-        options.parse_positional({ "filename" });
+        options.parse_positional({ "filenames" });
+        options.positional_help("<files>");
 
         auto result = options.parse(argc, argv);
-        if (result["filename"].count())
-            print_mesh_info(result["filename"].as<std::string>());
+        auto prof_format = ProfileFormat::TABLE;
+        if (result.count("profile")) {
+            prof_format = profile_format(result["profile"].as<std::string>());
+            profile.enable();
+        }
+        if (result["filenames"].count()) {
+            auto filenames = expand_globs(result["filenames"].as<std::vector<std::string>>());
+            if (result.count("stats")) {
+                StatsOptions stats_opts;
+                if (result.count("vars"))
+                    stats_opts.vars = result["vars"].as<std::vector<std::string>>();
+                stats_opts.times = time_selection(result["times"].as<std::string>());
+                ThreadPool pool(result["jobs"].as<unsigned int>());
+                for (std::size_t i = 0; i < filenames.size(); ++i) {
+                    if (i > 0)
+                        fmt::print("\n");
+                    fmt::print("File: {}\n", filenames[i]);
+                    print_stats(filenames[i], stats_opts, pool);
+                }
+            }
+            else if (filenames.size() == 1)
+                print_mesh_info(filenames[0]);
+            else if (!print_batch_info(filenames, result["jobs"].as<unsigned int>())) {
+                profile.report(prof_format, stderr);
+                return 1;
+            }
+            profile.report(prof_format, stderr);
+        }
         else {
             fmt::print("{}\n", options.help());
         }
@@ -2,338 +2,2278 @@
 // SPDX-License-Identifier: MIT
 
 #include <cstdlib>
+#include "common.h"
+#include "element_traits.h"
+#include "exo_header.h"
+#include "exo_writer.h"
+#include "external_dedup.h"
+#include "io_lock.h"
+#include "join_map.h"
+#include "kernels.h"
+#include "nc_classic.h"
+#include "node_dedup.h"
+#include "node_sort.h"
+#include "profile.h"
+#include "progress.h"
+#include "reorder.h"
+#include "thread_pool.h"
+#include "time_axis.h"
+#include "time_selection.h"
+#ifdef EXODUSII_UTILS_MPI
+    #include "mpi_dedup.h"
+#endif
 #include "cxxopts/cxxopts.hpp"
 #include <exodusIIcpp/enums.h>
 #include <exodusIIcpp/exodusIIcpp.h>
 #include <exodusIIcpp/file.h>
 #include <fmt/core.h>
+#include <algorithm>
 #include <set>
 #include <stdexcept>
 #include <vector>
 #include <string>
 #include <numeric>
 #include <cassert>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <optional>
 
-/// Snap tolerance on points
-constexpr double SNAP_TOLERANCE = 1e-10;
-
-enum class ElementType {
-    //
-    POINT1,
-    SEGMENT2,
-    TRI3,
-    QUAD4,
-    TET4,
-    HEX8,
-    PRISM6,
-    PYRAMID5
+/// Default snap tolerance on points, relative to the largest extent of the first input
+constexpr double RELATIVE_TOLERANCE = 1e-10;
+
+using NodeMap = std::map<int, int>;
+
+/// How global node IDs are assigned
+enum class Dedup {
+    /// Incremental hash-grid matching, IDs in order of first appearance
+    HASH,
+    /// Bulk sort of snapped coordinates, IDs in spatial order
+    SORT,
+    /// Same numbering as `SORT`, sorted out of core in runs spilled to scratch files
+    EXTERNAL
 };
 
-struct Point {
-    double x, y, z;
+/// Options controlling the join
+struct JoinOptions {
+    /// Node deduplication method
+    Dedup dedup = Dedup::HASH;
+    /// Renumbering of output nodes and elements
+    Reorder reorder = Reorder::NONE;
+    /// Only match nodes that lie in regions where input bounding boxes overlap
+    bool interface_only = false;
+    /// Number of reader threads
+    unsigned int n_jobs = 1;
+    /// Output compression
+    Compression compression = Compression::NONE;
+    /// Output compression level
+    int compression_level = 1;
+    /// Number of time steps buffered for the writer thread
+    unsigned int write_buffers = 2;
+    /// Flush the output to disk every this many time steps (0 = only at the end)
+    unsigned int sync_every = 1;
+    /// Time steps to join
+    TimeSelection times;
+    /// Number of consecutive time segments (e.g. restarts) the inputs are given in
+    std::size_t segments = 1;
+    /// Names of variables to join (empty = all)
+    std::vector<std::string> vars;
+    /// Append new time steps to an existing output instead of overwriting it
+    bool append = false;
+    /// Directory with cached join maps (empty = no caching)
+    std::string map_cache;
+    /// Read bulk arrays of netCDF-3 inputs straight from a memory map of the file
+    bool mmap = false;
+    /// Memory budget of the external dedup in bytes
+    std::size_t mem_limit = std::size_t(1) << 30;
+    /// Directory for the runs of the external dedup
+    std::string scratch_dir;
+    /// Snap tolerance (0 = `RELATIVE_TOLERANCE` times the largest extent of the first input)
+    double tol = 0;
 };
 
-bool
-operator<(const Point & a, const Point & b)
-{
-    if (a.x != b.x)
-        return a.x < b.x;
-    if (a.y != b.y)
-        return a.y < b.y;
-    return a.z < b.z;
-}
+/// Axis-aligned bounding box
+struct BoundingBox {
+    double lo[3] = { std::numeric_limits<double>::max(),
+                     std::numeric_limits<double>::max(),
+                     std::numeric_limits<double>::max() };
+    double hi[3] = { std::numeric_limits<double>::lowest(),
+                     std::numeric_limits<double>::lowest(),
+                     std::numeric_limits<double>::lowest() };
 
-using NodeMap = std::map<int, int>;
+    void
+    expand(double x, double y, double z)
+    {
+        this->lo[0] = std::min(this->lo[0], x);
+        this->lo[1] = std::min(this->lo[1], y);
+        this->lo[2] = std::min(this->lo[2], z);
+        this->hi[0] = std::max(this->hi[0], x);
+        this->hi[1] = std::max(this->hi[1], y);
+        this->hi[2] = std::max(this->hi[2], z);
+    }
 
-/// Variable values. Time steps, variables, values
-using NodalVariableValues = std::vector<std::vector<std::vector<double>>>;
+    bool
+    contains(double x, double y, double z) const
+    {
+        return this->lo[0] <= x && x <= this->hi[0] && this->lo[1] <= y && y <= this->hi[1] &&
+               this->lo[2] <= z && z <= this->hi[2];
+    }
+
+    bool
+    empty() const
+    {
+        return this->lo[0] > this->hi[0] || this->lo[1] > this->hi[1] || this->lo[2] > this->hi[2];
+    }
+
+    /// Grow the box to contain `other`
+    void
+    expand(const BoundingBox & other)
+    {
+        if (other.empty())
+            return;
+        expand(other.lo[0], other.lo[1], other.lo[2]);
+        expand(other.hi[0], other.hi[1], other.hi[2]);
+    }
+
+    /// Length of the longest side (0 if empty)
+    double
+    extent() const
+    {
+        if (empty())
+            return 0.;
+        return std::max({ this->hi[0] - this->lo[0],
+                          this->hi[1] - this->lo[1],
+                          this->hi[2] - this->lo[2] });
+    }
+
+    /// Grow the box by `d` in every direction
+    BoundingBox
+    inflated(double d) const
+    {
+        BoundingBox bbox = *this;
+        for (int i = 0; i < 3; ++i) {
+            bbox.lo[i] -= d;
+            bbox.hi[i] += d;
+        }
+        return bbox;
+    }
+
+    /// Intersection with `other` (empty if they do not overlap)
+    BoundingBox
+    intersection(const BoundingBox & other) const
+    {
+        BoundingBox bbox;
+        for (int i = 0; i < 3; ++i) {
+            bbox.lo[i] = std::max(this->lo[i], other.lo[i]);
+            bbox.hi[i] = std::min(this->hi[i], other.hi[i]);
+        }
+        return bbox;
+    }
+};
+
+/// Snap tolerance of a join
+///
+/// The default follows from the first input only, whose coordinates every method has at hand
+/// before it numbers any node, so it costs no extra pass over the inputs. The parts of a
+/// decomposed mesh have extents of the same order, which is all the tolerance needs.
+///
+/// @param opts Join options
+/// @param bbox Bounding box of the first input, used when no tolerance was given
+double
+snap_tolerance(const JoinOptions & opts, const BoundingBox & bbox)
+{
+    if (opts.tol > 0)
+        return opts.tol;
+    // a mesh without extent (or without nodes) is treated as unit sized
+    auto extent = bbox.extent();
+    return RELATIVE_TOLERANCE * (extent > 0 ? extent : 1.);
+}
 
 /// Block ID -> num elements per node
-std::map<int, int> num_nodes_per_elem;
-
-/// Convert string representation of an element type into enum
-ElementType
-element_type(std::string_view str)
-{
-    if (str == "BAR2")
-        return ElementType::SEGMENT2;
-    else if (str == "TRI" || str == "TRI3")
-        return ElementType::TRI3;
-    else if (str == "QUAD" || str == "QUAD4")
-        return ElementType::QUAD4;
-    else
-        throw std::runtime_error(fmt::format("Unsupported element type {}", str));
+std::map<int64_t, int> num_nodes_per_elem;
+
+/// Lay out the output element blocks from the headers of all input files
+///
+/// Each input's elements go after those of the preceding inputs in every block.
+///
+/// @param headers Headers of the input files
+/// @param block_ids Block IDs
+/// @param block_element_type Block ID -> element type
+/// @param elem_offset File index -> block ID -> position of the input's first element in the block
+/// @return Block ID -> number of elements
+std::map<int64_t, int64_t>
+layout_blocks(const std::vector<ExoHeader> & headers,
+              std::set<int64_t> & block_ids,
+              std::map<int64_t, ElementType> & block_element_type,
+              std::vector<std::map<int64_t, int64_t>> & elem_offset)
+{
+    std::map<int64_t, int64_t> block_n_elems;
+    elem_offset.resize(headers.size());
+    for (std::size_t i = 0; i < headers.size(); ++i) {
+        for (auto & blk : headers[i].blocks) {
+            auto [it, inserted] = num_nodes_per_elem.emplace(blk.id, blk.n_nodes_per_elem);
+            if (it->second != blk.n_nodes_per_elem)
+                throw std::runtime_error(
+                    fmt::format("Block {} has {} nodes per element in one input and {} in another",
+                                blk.id,
+                                it->second,
+                                blk.n_nodes_per_elem));
+            auto et = element_type(blk.element_type);
+            if (blk.n_nodes_per_elem != num_nodes(et))
+                throw std::runtime_error(
+                    fmt::format("Block {} has {} nodes per element, {} elements have {}",
+                                blk.id,
+                                blk.n_nodes_per_elem,
+                                blk.element_type,
+                                num_nodes(et)));
+            block_ids.insert(blk.id);
+            block_element_type.emplace(blk.id, et);
+            elem_offset[i][blk.id] = block_n_elems[blk.id];
+            block_n_elems[blk.id] += blk.n_elems;
+        }
+    }
+    return block_n_elems;
 }
 
-const char *
-element_type_str(ElementType et)
+/// Throw if a side set entry refers to a side its element does not have
+///
+/// @param ss_id Side set ID
+/// @param blk_id Block ID of the element
+/// @param et Element type of the block
+/// @param side Side ID (1-based)
+void
+check_side(int64_t ss_id, int64_t blk_id, ElementType et, int64_t side)
 {
-    if (et == ElementType::SEGMENT2)
-        return "BAR2";
-    else if (et == ElementType::TRI3)
-        return "TRI3";
-    else if (et == ElementType::QUAD4)
-        return "QUAD4";
-    else if (et == ElementType::TET4)
-        return "TET4";
-    else
-        throw std::runtime_error(fmt::format("Unsupported element type"));
+    if (side < 1 || side > num_sides(et))
+        throw std::runtime_error(
+            fmt::format("Side set {} refers to side {} of a {} element in block {}",
+                        ss_id,
+                        side,
+                        exodus_element_name(et),
+                        blk_id));
 }
 
-/// Snap a point to a grid
-inline Point
-snap_point(const Point & p, double tol)
+/// Closes an input file under the I/O lock
+struct InputFileDeleter {
+    void
+    operator()(exodusIIcpp::File * exo) const
+    {
+        auto lock = lock_io();
+        delete exo;
+    }
+};
+
+/// Input file that can be handed over between threads
+using InputFile = std::unique_ptr<exodusIIcpp::File, InputFileDeleter>;
+
+/// Names of joined variables
+struct VariableNames {
+    std::vector<std::string> nodal;
+    std::vector<std::string> elem;
+    std::vector<std::string> global;
+};
+
+/// Variables to join with their indices (1-based) in the input files
+struct VariableSelection {
+    VariableNames names;
+    std::vector<int> nodal;
+    std::vector<int> elem;
+    std::vector<int> global;
+};
+
+/// Pick variables to join
+///
+/// @param all Variables in the input files
+/// @param wanted Names of variables to join (of any kind), empty to join all of them
+VariableSelection
+select_variables(const VariableNames & all, const std::vector<std::string> & wanted)
 {
-    auto snap = [tol](double v) {
-        return std::round(v / tol) * tol;
+    VariableSelection sel;
+    std::set<std::string> found;
+    auto pick = [&](const std::vector<std::string> & names,
+                    std::vector<std::string> & sel_names,
+                    std::vector<int> & sel_idx) {
+        for (std::size_t i = 0; i < names.size(); ++i) {
+            if (wanted.empty() ||
+                std::find(wanted.begin(), wanted.end(), names[i]) != wanted.end()) {
+                sel_names.push_back(names[i]);
+                sel_idx.push_back(i + 1);
+                found.insert(names[i]);
+            }
+        }
     };
-    return { snap(p.x), snap(p.y), snap(p.z) };
+    pick(all.nodal, sel.names.nodal, sel.nodal);
+    pick(all.elem, sel.names.elem, sel.elem);
+    pick(all.global, sel.names.global, sel.global);
+    for (auto & name : wanted)
+        if (found.count(name) == 0)
+            throw std::runtime_error(fmt::format("Variable '{}' not found", name));
+    return sel;
 }
 
-/// @param connect Block connectivity (from exodusii) - 1-based indexing
-void
-remap_connectivity(std::vector<int> & connect, const std::vector<int> & is)
+/// Input file with its mesh loaded by the reader stage
+struct InputMesh {
+    InputFile exo;
+    /// Memory map of the file (`nullptr` if not mapped)
+    std::unique_ptr<ClassicFile> mapped;
+    /// Coordinates are taken from `mapped` rather than read into `exo`
+    bool mapped_coords = false;
+    std::vector<double> times;
+};
+
+/// Side set entry, with the element given relative to its block in its input file
+struct SideEntry {
+    /// Input file index
+    int file;
+    /// Block ID
+    int64_t block;
+    /// Element index within the block in the input file (0-based)
+    int64_t elem;
+    /// Side (1-based)
+    int side;
+};
+
+/// Open and initialize an input file
+InputFile
+open_input(const std::string & filename)
+{
+    auto lock = lock_io();
+    InputFile exo(new exodusIIcpp::File(filename, exodusIIcpp::FileAccess::READ));
+    exo->init();
+    return exo;
+}
+
+/// Check if a mapped file has nodal coordinates in the layout `with_coords()` reads
+bool
+has_mapped_coords(const ClassicFile & file, int dim)
+{
+    auto * x = file.find("coordx");
+    auto * y = file.find("coordy");
+    auto * z = file.find("coordz");
+    if (x == nullptr || y == nullptr || (dim == 3 && z == nullptr))
+        return false;
+    if (x->type != NC_TYPE_DOUBLE && x->type != NC_TYPE_FLOAT)
+        return false;
+    return y->type == x->type && (dim == 2 || z->type == x->type);
+}
+
+/// Map input files that are in one of the netCDF-3 formats
+///
+/// @return Mapped file for each input, `nullptr` for inputs in other formats (netCDF-4)
+std::vector<std::unique_ptr<ClassicFile>>
+map_inputs(const std::vector<std::string> & inputs)
+{
+    std::vector<std::unique_ptr<ClassicFile>> mapped;
+    for (auto & input : inputs)
+        mapped.push_back(ClassicFile::open(input));
+    return mapped;
+}
+
+/// Open an input file and read coordinates, sets and time steps
+///
+/// Connectivity is not read here, see `read_connectivity()`.
+///
+/// @param filename Input file name
+/// @param coords Read nodal coordinates
+/// @param map Map the file if it is in one of the netCDF-3 formats, coordinates are then not read
+///        but used in place
+InputMesh
+load_input(const std::string & filename, bool coords = true, bool map = false)
 {
-    for (auto & idx : connect)
-        idx = is[idx - 1] + 1;
+    InputMesh mesh;
+    if (map)
+        mesh.mapped = ClassicFile::open(filename);
+    auto lock = lock_io();
+    mesh.exo = open_input(filename);
+    if (coords && mesh.mapped)
+        mesh.mapped_coords = has_mapped_coords(*mesh.mapped, mesh.exo->get_dim());
+    if (coords && !mesh.mapped_coords)
+        mesh.exo->read_coords();
+    mesh.exo->read_node_sets();
+    mesh.exo->read_side_sets();
+    mesh.exo->read_times();
+    mesh.times = mesh.exo->get_times();
+    return mesh;
 }
 
-/// Scatter values from `src` into `dest` using `idx` as a map
+/// Append coordinates of an input file to `x`, `y` and `z`
+///
+/// @param exo Input file with coordinates read
+/// @param dim Spatial dimension
 void
-scatter(const std::vector<double> & src, const std::vector<int> & idx, std::vector<double> & dest)
+append_coords(exodusIIcpp::File & exo,
+              int dim,
+              std::vector<double> & x,
+              std::vector<double> & y,
+              std::vector<double> & z)
 {
-    assert(src.size() == idx.size());
-    for (std::size_t i = 0; i < src.size(); ++i) {
-        dest[idx[i]] = src[i];
+    auto n_nodes = exo.get_num_nodes();
+    const auto & ex = exo.get_x_coords();
+    const auto & ey = exo.get_y_coords();
+    x.insert(x.end(), ex.begin(), ex.end());
+    y.insert(y.end(), ey.begin(), ey.end());
+    if (dim == 2)
+        z.insert(z.end(), n_nodes, 0.);
+    else if (dim == 3) {
+        const auto & ez = exo.get_z_coords();
+        z.insert(z.end(), ez.begin(), ez.end());
+    }
+    else
+        throw std::runtime_error(fmt::format("Unsupported dimension {}", dim));
+}
+
+/// Stand-in for the z coordinates of 2D meshes
+struct ZeroCoords {
+    double
+    operator[](std::size_t) const
+    {
+        return 0.;
     }
+};
+
+/// Bounding box of points
+template <typename X, typename Y, typename Z>
+BoundingBox
+bounding_box(const X & x, const Y & y, const Z & z)
+{
+    BoundingBox bbox;
+    for (std::size_t i = 0; i < x.size(); ++i)
+        bbox.expand(x[i], y[i], z[i]);
+    return bbox;
 }
 
-std::map<int, ElementType>
-read_element_types(exodusIIcpp::File & exo)
+/// @param exo Input file with coordinates read
+BoundingBox
+read_bounding_box(exodusIIcpp::File & exo, int dim)
 {
-    std::map<int, ElementType> block_element_type;
+    if (dim == 2)
+        return bounding_box(exo.get_x_coords(), exo.get_y_coords(), ZeroCoords());
+    else if (dim == 3)
+        return bounding_box(exo.get_x_coords(), exo.get_y_coords(), exo.get_z_coords());
+    else
+        throw std::runtime_error(fmt::format("Unsupported dimension {}", dim));
+}
 
-    for (auto & eb : exo.get_element_blocks()) {
-        auto id = eb.get_id();
-        auto elem_type_s = eb.get_element_type();
-        auto et = element_type(elem_type_s);
-        block_element_type.emplace(id, et);
+/// Find regions where input files can have coincident nodes
+///
+/// @param bboxes Bounding boxes of input files
+/// @param tol Snap tolerance
+/// @return For each input file, intersections of its bounding box with other inputs' boxes
+std::vector<std::vector<BoundingBox>>
+find_interfaces(const std::vector<BoundingBox> & bboxes, double tol)
+{
+    std::vector<std::vector<BoundingBox>> interfaces(bboxes.size());
+    for (std::size_t i = 0; i < bboxes.size(); ++i) {
+        auto bi = bboxes[i].inflated(tol);
+        for (std::size_t j = i + 1; j < bboxes.size(); ++j) {
+            auto overlap = bi.intersection(bboxes[j].inflated(tol));
+            if (!overlap.empty()) {
+                interfaces[i].push_back(overlap);
+                interfaces[j].push_back(overlap);
+            }
+        }
     }
+    return interfaces;
+}
 
-    return block_element_type;
+/// Check if a point lies in any of the `regions`
+inline bool
+in_any(const std::vector<BoundingBox> & regions, double x, double y, double z)
+{
+    for (auto & r : regions)
+        if (r.contains(x, y, z))
+            return true;
+    return false;
 }
 
+/// Call `fn(x, y, z)` with the nodal coordinates of an input file
+///
+/// The arrays are either the vectors read by the exodusII library or views into the memory map of
+/// the file. `z` reads as zeros for 2D meshes.
+///
+/// @param mesh Input file with coordinates read or mapped
+/// @param dim Spatial dimension
+template <typename FN>
 void
-read_block_ids(exodusIIcpp::File & exo, std::set<int64_t> & block_ids)
+with_coords(InputMesh & mesh, int dim, FN && fn)
 {
-    for (auto & eb : exo.get_element_blocks()) {
-        auto id = eb.get_id();
-        block_ids.insert(id);
+    if (dim != 2 && dim != 3)
+        throw std::runtime_error(fmt::format("Unsupported dimension {}", dim));
+    if (mesh.mapped_coords) {
+        auto & file = *mesh.mapped;
+        auto mapped = [&](auto value) {
+            using T = decltype(value);
+            auto x = file.array<T>(*file.find("coordx"));
+            auto y = file.array<T>(*file.find("coordy"));
+            if (dim == 3)
+                fn(x, y, file.array<T>(*file.find("coordz")));
+            else
+                fn(x, y, ZeroCoords());
+        };
+        if (file.find("coordx")->type == NC_TYPE_DOUBLE)
+            mapped(double());
+        else
+            mapped(float());
+    }
+    else {
+        auto & exo = *mesh.exo;
+        if (dim == 3)
+            fn(exo.get_x_coords(), exo.get_y_coords(), exo.get_z_coords());
+        else
+            fn(exo.get_x_coords(), exo.get_y_coords(), ZeroCoords());
     }
 }
 
-std::vector<int>
-read_file(exodusIIcpp::File & exo, int dim, std::map<Point, int> & node_map)
+/// Build global node IDs for nodes of an input file
+///
+/// @param x x-coordinates of the input's nodes
+/// @param y y-coordinates of the input's nodes
+/// @param z z-coordinates of the input's nodes
+/// @param nodes Unique nodes
+/// @param interface Regions where nodes can coincide with other inputs' nodes. Nodes outside of
+///        these regions are numbered without matching. If `nullptr`, all nodes are matched.
+/// @return Global node IDs (0-based) indexed by local node index
+template <typename INT, typename X, typename Y, typename Z>
+std::vector<INT>
+read_file(const X & x,
+          const Y & y,
+          const Z & z,
+          NodeDedup<INT> & nodes,
+          const std::vector<BoundingBox> * interface = nullptr)
 {
+    auto add_node = [&](double x, double y, double z) {
+        if (interface == nullptr || in_any(*interface, x, y, z))
+            return nodes.insert(x, y, z);
+        else
+            return nodes.append(x, y, z);
+    };
+
     // build nodes
-    auto n_nodes = exo.get_num_nodes();
-    std::vector<int> is(n_nodes);
-    exo.read_coords();
-    if (dim == 2) {
-        auto x = exo.get_x_coords();
-        auto y = exo.get_y_coords();
-        for (int i = 0; i < n_nodes; ++i) {
-            auto pt = snap_point({ x[i], y[i], 0. }, SNAP_TOLERANCE);
-            auto [it, inserted] = node_map.emplace(pt, node_map.size());
-            is[i] = it->second;
-        }
+    std::size_t n_nodes = x.size();
+    std::vector<INT> is(n_nodes);
+    if (interface == nullptr)
+        nodes.reserve(nodes.size() + n_nodes);
+    else
+        nodes.reserve(nodes.size() + n_nodes, 0);
+    for (std::size_t i = 0; i < n_nodes; ++i)
+        is[i] = add_node(x[i], y[i], z[i]);
+
+    return is;
+}
+
+/// Read connectivity of all blocks of an input file straight into the output blocks
+///
+/// @param filename Input file name
+/// @param hdr Header of the input file
+/// @param elem_offset Block ID -> position of the input's first element in the output block
+/// @param block_connect Block ID -> connectivity array (1-based), sized for all inputs
+/// @param mapped Memory map of the file, blocks found in it are copied from the map without going
+///        through the exodusII library
+template <typename INT>
+void
+read_connectivity(const std::string & filename,
+                  const ExoHeader & hdr,
+                  const std::map<int64_t, int64_t> & elem_offset,
+                  std::map<int64_t, std::vector<INT>> & block_connect,
+                  const ClassicFile * mapped = nullptr)
+{
+    auto copy = [](const auto & src, INT * dest) {
+        for (std::size_t k = 0; k < src.size(); ++k)
+            dest[k] = static_cast<INT>(src[k]);
+    };
+
+    std::vector<const BlockHeader *> unmapped;
+    for (std::size_t j = 0; j < hdr.blocks.size(); ++j) {
+        auto & blk = hdr.blocks[j];
+        if (blk.n_elems == 0)
+            continue;
+        auto first = elem_offset.at(blk.id) * blk.n_nodes_per_elem;
+        auto * dest = block_connect.at(blk.id).data() + first;
+        // exodusII names connectivity by the block's index in the file
+        auto * var = mapped ? mapped->find(fmt::format("connect{}", j + 1)) : nullptr;
+        auto n = static_cast<std::size_t>(blk.n_elems * blk.n_nodes_per_elem);
+        if (var == nullptr || var->n != n)
+            unmapped.push_back(&blk);
+        else if (var->type == NC_TYPE_INT)
+            copy(mapped->array<int32_t>(*var), dest);
+        else if (var->type == NC_TYPE_INT64)
+            copy(mapped->array<int64_t>(*var), dest);
+        else
+            unmapped.push_back(&blk);
     }
-    else if (dim == 3) {
-        auto x = exo.get_x_coords();
-        auto y = exo.get_y_coords();
-        auto z = exo.get_z_coords();
-        for (int i = 0; i < n_nodes; ++i) {
-            auto pt = snap_point({ x[i], y[i], z[i] }, SNAP_TOLERANCE);
-            auto [it, inserted] = node_map.emplace(pt, node_map.size());
-            is[i] = it->second;
+    if (unmapped.empty())
+        return;
+
+    auto lock = lock_io();
+    detail::ExoHandle exo(filename);
+    ex_set_int64_status(exo.exoid, sizeof(INT) == 8 ? EX_BULK_INT64_API : 0);
+    for (auto * blk : unmapped) {
+        auto first = elem_offset.at(blk->id) * blk->n_nodes_per_elem;
+        auto * dest = block_connect.at(blk->id).data() + first;
+        detail::check_ex(ex_get_conn(exo.exoid, EX_ELEM_BLOCK, blk->id, dest, nullptr, nullptr),
+                         "ex_get_conn");
+    }
+}
+
+/// Renumber nodes and elements within each block for locality
+///
+/// @param method Reordering method
+/// @param nodes Unique nodes
+/// @param block_element_type Block ID -> element type
+/// @param index_set File index -> global node IDs (0-based), updated to the new numbering
+/// @param block_connect Block ID -> connectivity array (1-based), updated to the new numbering
+/// @param elem_dest File index -> block ID -> output positions of the file's elements, updated to
+///        the new numbering
+template <typename INT>
+void
+reorder_mesh(Reorder method,
+             NodeDedup<INT> & nodes,
+             const std::map<int64_t, ElementType> & block_element_type,
+             std::map<int, std::vector<INT>> & index_set,
+             std::map<int64_t, std::vector<INT>> & block_connect,
+             std::vector<std::map<int64_t, std::vector<INT>>> & elem_dest)
+{
+    auto order = method == Reorder::RCM
+                     ? rcm_order(nodes.size(), block_connect, num_nodes_per_elem)
+                     : order_by_keys<INT>(sfc_keys(method, nodes.x(), nodes.y(), nodes.z()));
+    std::vector<INT> new_id(order.size());
+    for (std::size_t k = 0; k < order.size(); ++k)
+        new_id[order[k]] = k;
+
+    nodes.permute(order);
+    for (auto & [fi, is] : index_set)
+        for (auto & idx : is)
+            idx = new_id[idx];
+
+    for (auto & [id, connect] : block_connect) {
+        for (auto & idx : connect)
+            idx = new_id[idx - 1] + 1;
+
+        auto et = block_element_type.at(id);
+        auto elem_order = element_order(method, connect, et, nodes.x(), nodes.y(), nodes.z());
+        std::vector<INT> permuted(connect.size());
+        dispatch(et, [&](auto traits) {
+            gather_elements<decltype(traits)::N_NODES>(connect.data(),
+                                                       elem_order,
+                                                       permuted.data());
+        });
+        std::swap(connect, permuted);
+        std::vector<INT> new_pos(elem_order.size());
+        for (std::size_t k = 0; k < elem_order.size(); ++k)
+            new_pos[elem_order[k]] = k;
+
+        for (auto & file_dest : elem_dest) {
+            auto it = file_dest.find(id);
+            if (it != file_dest.end())
+                for (auto & pos : it->second)
+                    pos = new_pos[pos];
         }
     }
+}
+
+template <typename INT>
+void
+write_nodes(ExoWriter & exo, int dim, const NodeDedup<INT> & nodes)
+{
+    if (dim == 2)
+        exo.write_coords(nodes.x(), nodes.y());
+    else if (dim == 3)
+        exo.write_coords(nodes.x(), nodes.y(), nodes.z());
     else
         throw std::runtime_error(fmt::format("Unsupported dimension {}", dim));
+}
 
-    return is;
+template <typename INT>
+void
+write_elements(ExoWriter & exo,
+               const std::set<int64_t> & block_ids,
+               const std::map<int64_t, ElementType> & block_element_type,
+               const std::map<int64_t, std::vector<INT>> & block_connect)
+{
+    for (auto blk_id : block_ids) {
+        int64_t n_elems_in_block = block_connect.at(blk_id).size() / num_nodes_per_elem[blk_id];
+        auto elem_type = exodus_element_name(block_element_type.at(blk_id));
+        exo.write_block(blk_id, elem_type, n_elems_in_block, block_connect.at(blk_id));
+    }
+}
+
+/// @param node_sets Node set ID -> (file index, local node index (0-based)) entries
+/// @param index_set File index -> global node IDs (0-based)
+template <typename INT>
+void
+write_node_sets(ExoWriter & exo,
+                const std::map<int, std::vector<std::pair<int, INT>>> & node_sets,
+                const std::map<int, std::vector<INT>> & index_set)
+{
+    for (auto & [id, entries] : node_sets) {
+        std::vector<INT> node_ids;
+        node_ids.reserve(entries.size());
+        for (auto & [fi, n] : entries)
+            node_ids.push_back(index_set.at(fi)[n] + 1);
+        // interface nodes are in the set once per input that has them
+        std::sort(node_ids.begin(), node_ids.end());
+        node_ids.erase(std::unique(node_ids.begin(), node_ids.end()), node_ids.end());
+        exo.write_node_set(id, node_ids);
+    }
 }
 
-std::map<int, std::vector<int>>
-read_elements(exodusIIcpp::File & exo)
+/// @param side_sets Side set ID -> entries
+/// @param elem_dest File index -> block ID -> output positions of the file's elements
+/// @param block_ids Block IDs in output order
+/// @param block_connect Block ID -> connectivity array
+template <typename INT>
+void
+write_side_sets(ExoWriter & exo,
+                const std::map<int, std::vector<SideEntry>> & side_sets,
+                const std::vector<std::map<int64_t, std::vector<INT>>> & elem_dest,
+                const std::set<int64_t> & block_ids,
+                const std::map<int64_t, std::vector<INT>> & block_connect)
 {
-    std::map<int, std::vector<int>> blocks;
+    // ID of the first element of each block in the output (0-based)
+    std::map<int64_t, int64_t> block_start;
+    int64_t n_elems = 0;
+    for (auto blk_id : block_ids) {
+        block_start[blk_id] = n_elems;
+        n_elems += block_connect.at(blk_id).size() / num_nodes_per_elem[blk_id];
+    }
+
+    for (auto & [id, entries] : side_sets) {
+        std::vector<INT> elems;
+        std::vector<INT> sides;
+        elems.reserve(entries.size());
+        sides.reserve(entries.size());
+        for (auto & e : entries) {
+            elems.push_back(block_start[e.block] + elem_dest[e.file].at(e.block)[e.elem] + 1);
+            sides.push_back(e.side);
+        }
+        exo.write_side_set(id, elems, sides);
+    }
+}
 
-    for (auto & eb : exo.get_element_blocks()) {
-        auto id = eb.get_id();
-        auto elem_type_s = eb.get_element_type();
+/// Which values of an input file supply which global nodes
+template <typename INT>
+struct GatherPlan {
+    /// Local node indices (0-based) into the input's arrays
+    std::vector<INT> src;
+    /// Global node IDs (0-based), ascending
+    std::vector<INT> dest;
+};
 
-        auto nn = eb.get_num_nodes_per_element();
-        num_nodes_per_elem[id] = nn;
+/// Build gather plans for all input files
+///
+/// A global node shared by several inputs is supplied by the first input that has it, so every
+/// global node is written exactly once per variable and step.
+///
+/// @param index_set File index -> global node IDs (0-based)
+/// @param n_nodes Number of global nodes
+/// @return Gather plan for each input file
+template <typename INT>
+std::vector<GatherPlan<INT>>
+build_gather_plans(const std::map<int, std::vector<INT>> & index_set, std::size_t n_nodes)
+{
+    std::vector<GatherPlan<INT>> plans(index_set.size());
+    std::vector<char> owned(n_nodes, 0);
+    for (auto & [fi, is] : index_set) {
+        std::vector<std::pair<INT, INT>> entries;
+        bool ascending = true;
+        for (std::size_t i = 0; i < is.size(); ++i) {
+            auto g = is[i];
+            if (!owned[g]) {
+                owned[g] = 1;
+                ascending = ascending && (entries.empty() || entries.back().first < g);
+                entries.emplace_back(g, i);
+            }
+        }
+        if (!ascending)
+            std::sort(entries.begin(), entries.end());
 
-        auto connect = eb.get_connectivity();
-        blocks.emplace(id, connect);
+        auto & plan = plans[fi];
+        plan.src.reserve(entries.size());
+        plan.dest.reserve(entries.size());
+        for (auto & [g, i] : entries) {
+            plan.dest.push_back(g);
+            plan.src.push_back(i);
+        }
     }
+    return plans;
+}
 
-    return blocks;
+/// Copy values of an input's array to global nodes through its gather plan
+///
+/// @param src Values of the input's nodes
+/// @param plan Gather plan of the input
+/// @param dest Values of global nodes
+template <typename SRC, typename INT>
+void
+gather(const SRC & src, const GatherPlan<INT> & plan, std::vector<double> & dest)
+{
+    for (std::size_t k = 0; k < plan.src.size(); ++k)
+        dest[plan.dest[k]] = src[plan.src[k]];
 }
 
-NodalVariableValues
-read_nodal_vals(exodusIIcpp::File & exo)
+/// Variable values of one input file at one time step
+struct StepValues {
+    /// Nodal variable -> values
+    std::vector<std::vector<double>> nodal;
+    /// Nodal variable -> its values in the memory map of the input, used instead of `nodal`
+    std::vector<const ClassicFile::Var *> nodal_mapped;
+    /// Block ID -> element variable -> values
+    std::map<int64_t, std::vector<std::vector<double>>> elem;
+    /// Global variable values
+    std::vector<double> global;
+};
+
+/// Joined variable values of one time step
+struct StepBuffer {
+    /// Nodal variable -> values
+    std::vector<std::vector<double>> nodal;
+    /// Block ID -> element variable -> values
+    std::map<int64_t, std::vector<std::vector<double>>> elem;
+    /// Global variable values
+    std::vector<double> global;
+};
+
+/// Element variables of an input file: block ID -> selected element variable -> non-zero if the
+/// variable has values on the block
+using ElemTruth = std::map<int64_t, std::vector<int>>;
+
+/// Read which of the selected element variables have values on the blocks of an input file
+///
+/// Blocks without elements have no values.
+ElemTruth
+read_elem_truth(const std::string & filename,
+                const ExoHeader & hdr,
+                const VariableSelection & vars)
 {
-    auto n_nodal_vars = exo.get_nodal_variable_names().size();
+    ElemTruth truth;
+    if (vars.elem.empty())
+        return truth;
+    std::vector<int> table;
+    {
+        auto lock = lock_io();
+        detail::ExoHandle exo(filename);
+        table = read_truth_table(exo.exoid, hdr);
+    }
+    auto n_elem_vars = hdr.elem_var_names.size();
+    for (std::size_t b = 0; b < hdr.blocks.size(); ++b) {
+        auto & blk_truth = truth[hdr.blocks[b].id];
+        for (auto idx : vars.elem)
+            blk_truth.push_back(hdr.blocks[b].n_elems > 0 && table[b * n_elem_vars + idx - 1]);
+    }
+    return truth;
+}
 
-    auto n_times = exo.get_num_times();
-    NodalVariableValues nodal_var_values(n_times);
-    for (auto & var_vals : nodal_var_values)
-        var_vals.resize(n_nodal_vars);
+/// Read the element variable truth of the inputs of all segments
+///
+/// @return Segment -> file index -> truth of the input
+std::vector<std::vector<ElemTruth>>
+read_elem_truth(ThreadPool & pool,
+                const std::vector<std::vector<std::string>> & segments,
+                const std::vector<std::vector<ExoHeader>> & segment_headers,
+                const VariableSelection & vars)
+{
+    std::vector<std::vector<std::future<ElemTruth>>> pending(segments.size());
+    for (std::size_t s = 0; s < segments.size(); ++s)
+        for (std::size_t i = 0; i < segments[s].size(); ++i)
+            pending[s].push_back(pool.submit([&, s, i] {
+                return read_elem_truth(segments[s][i], segment_headers[s][i], vars);
+            }));
+    std::vector<std::vector<ElemTruth>> truth(segments.size());
+    for (std::size_t s = 0; s < segments.size(); ++s)
+        for (auto & f : pending[s])
+            truth[s].push_back(f.get());
+    return truth;
+}
 
-    std::vector<int> nodal_var_indices(n_nodal_vars);
-    std::iota(nodal_var_indices.begin(), nodal_var_indices.end(), 0);
+/// Truth table of the joined blocks: a variable has values on a block if it has them in any input
+///
+/// @param truth Segment -> file index -> truth of the input
+/// @param block_n_elems Block ID -> number of elements in the output block
+/// @param n_elem_vars Number of selected element variables
+/// @return Table in the layout of `ExoWriter::write_elem_truth_table()`, blocks in the order of
+///         their IDs
+std::vector<int>
+join_elem_truth(const std::vector<std::vector<ElemTruth>> & truth,
+                const std::map<int64_t, int64_t> & block_n_elems,
+                std::size_t n_elem_vars)
+{
+    std::vector<int> table(block_n_elems.size() * n_elem_vars, 0);
+    std::size_t b = 0;
+    for (auto & [blk_id, n] : block_n_elems) {
+        for (auto & segment : truth)
+            for (auto & file_truth : segment) {
+                auto it = file_truth.find(blk_id);
+                if (it == file_truth.end())
+                    continue;
+                for (std::size_t v = 0; v < n_elem_vars; ++v)
+                    table[b * n_elem_vars + v] |= it->second[v];
+            }
+        ++b;
+    }
+    return table;
+}
 
-    for (int t = 0; t < n_times; ++t)
-        for (auto & var_idx : nodal_var_indices)
-            nodal_var_values[t][var_idx] = exo.get_nodal_variable_values(t + 1, var_idx + 1);
+/// Define joined variables in the output
+///
+/// @param exo Output file
+/// @param names Names of the joined variables
+/// @param n_blocks Number of element blocks
+/// @param elem_truth Truth table of the joined blocks, see `join_elem_truth()`
+void
+write_variable_names(ExoWriter & exo,
+                     const VariableNames & names,
+                     int n_blocks,
+                     const std::vector<int> & elem_truth)
+{
+    auto lock = lock_io();
+    exo.write_nodal_var_names(names.nodal);
+    if (!names.elem.empty()) {
+        exo.write_elem_var_names(names.elem);
+        exo.write_elem_truth_table(n_blocks, names.elem.size(), elem_truth);
+    }
+    if (!names.global.empty())
+        exo.write_global_var_names(names.global);
+}
 
-    return nodal_var_values;
+/// Write one joined time step
+///
+/// @param exo Output file
+/// @param step Time step index (1-based)
+/// @param time Time
+/// @param buf Joined values
+/// @param sync Flush the file to disk afterwards
+inline void
+write_step(ExoWriter & exo, int step, double time, const StepBuffer & buf, bool sync)
+{
+    auto timer = profile.scope("write variables");
+    uint64_t bytes = sizeof(double) * (1 + buf.global.size());
+    for (auto & vals : buf.nodal)
+        bytes += vals.size() * sizeof(double);
+    for (auto & [blk_id, blk_vals] : buf.elem)
+        for (auto & vals : blk_vals)
+            bytes += vals.size() * sizeof(double);
+    profile.count("write variables", 0, bytes);
+    auto lock = lock_io();
+    exo.write_time(step, time);
+    for (std::size_t var_idx = 0; var_idx < buf.nodal.size(); ++var_idx)
+        exo.write_nodal_var(step, var_idx + 1, buf.nodal[var_idx]);
+    for (auto & [blk_id, blk_vals] : buf.elem)
+        for (std::size_t var_idx = 0; var_idx < blk_vals.size(); ++var_idx)
+            if (!blk_vals[var_idx].empty())
+                exo.write_elem_var(step, var_idx + 1, blk_id, blk_vals[var_idx]);
+    for (std::size_t var_idx = 0; var_idx < buf.global.size(); ++var_idx)
+        exo.write_global_var(step, var_idx + 1, buf.global[var_idx]);
+    if (sync)
+        exo.update();
+    progress.advance(1, bytes);
 }
 
+/// Stream variables from input files into the output one time step at a time
+///
+/// Each input's nodal variables are copied in a single pass over its gather plan, writing global
+/// nodes in ascending order. Element variables are placed at the positions the input's elements
+/// took in the joined blocks. Global variables are taken from the first input.
+///
+/// Nodal variables of mapped inputs are gathered straight from the map, the reader threads only ask
+/// the kernel to page them in.
+///
+/// Joined steps are written by a separate thread, so that step `t` is written while the following
+/// steps are gathered. `opts.write_buffers` steps of all variables for all global nodes and
+/// elements (plus the arrays of the inputs in flight) are held in memory at any time.
+///
+/// The inputs of a segment are opened when its first step comes up and closed when the next
+/// segment's are, so only one segment's files are open at a time.
+///
+/// @param exo Output file
+/// @param pool Reader threads
+/// @param segments Segment -> input file names, the same parts of the mesh in every segment
+/// @param plans Gather plan for each input file
+/// @param elem_dest File index -> block ID -> output positions of the file's elements
+/// @param block_n_elems Block ID -> number of elements in the output block
+/// @param truth Segment -> file index -> element variable truth of the input
+/// @param elem_truth Truth table of the joined blocks, see `join_elem_truth()`
+/// @param steps Time steps to join, ordered by segment
+/// @param step_offset Number of time steps already in the output
+/// @param n_nodes Number of global nodes
+/// @param vars Variables to join
+/// @param opts Join options
+template <typename INT>
 void
-write_nodes(exodusIIcpp::File & exo, int dim, const std::map<Point, int> & node_map)
-{
-    auto n_nodes = node_map.size();
-    if (dim == 2) {
-        std::vector<double> x(n_nodes, 0);
-        std::vector<double> y(n_nodes, 0);
-        for (auto & [pt, idx] : node_map) {
-            x[idx] = pt.x;
-            y[idx] = pt.y;
+write_variables(ExoWriter & exo,
+                ThreadPool & pool,
+                const std::vector<std::vector<std::string>> & segments,
+                const std::vector<GatherPlan<INT>> & plans,
+                const std::vector<std::map<int64_t, std::vector<INT>>> & elem_dest,
+                const std::map<int64_t, int64_t> & block_n_elems,
+                const std::vector<std::vector<ElemTruth>> & truth,
+                const std::vector<int> & elem_truth,
+                const std::vector<StepSource> & steps,
+                int step_offset,
+                std::size_t n_nodes,
+                const VariableSelection & vars,
+                const JoinOptions & opts)
+{
+    auto n_nodal_vars = vars.nodal.size();
+    auto n_elem_vars = vars.elem.size();
+    // inputs of the segment being read
+    std::size_t segment = segments.size();
+    std::vector<InputFile> inputs;
+    // memory map of each input file (`nullptr` or empty for unmapped inputs)
+    std::vector<std::unique_ptr<ClassicFile>> mapped;
+    // nodal variables in the maps, all of them or none for each input
+    std::vector<std::vector<const ClassicFile::Var *>> mapped_nodal;
+    auto open_segment = [&](std::size_t s) {
+        inputs.clear();
+        for (auto & input : segments[s])
+            inputs.push_back(open_input(input));
+        if (opts.mmap)
+            mapped = map_inputs(segments[s]);
+        mapped_nodal.assign(inputs.size(), {});
+        for (std::size_t fi = 0; fi < mapped.size(); ++fi) {
+            if (!mapped[fi])
+                continue;
+            auto n = static_cast<std::size_t>(inputs[fi]->get_num_nodes());
+            for (auto idx : vars.nodal) {
+                auto * var = mapped[fi]->find(fmt::format("vals_nod_var{}", idx));
+                if (var == nullptr || !var->record || var->n != n ||
+                    (var->type != NC_TYPE_DOUBLE && var->type != NC_TYPE_FLOAT)) {
+                    mapped_nodal[fi].clear();
+                    break;
+                }
+                mapped_nodal[fi].push_back(var);
+            }
+        }
+        segment = s;
+    };
+
+    progress.phase("variables", steps.size(), "steps");
+    std::vector<StepBuffer> buffers(std::max(opts.write_buffers, 1u));
+    for (auto & buf : buffers) {
+        buf.nodal.assign(n_nodal_vars, std::vector<double>(n_nodes));
+        std::size_t b = 0;
+        for (auto & [blk_id, n] : block_n_elems) {
+            // variables that are not on a block have no values to write
+            auto & blk_vals = buf.elem[blk_id];
+            blk_vals.resize(n_elem_vars);
+            for (std::size_t k = 0; k < n_elem_vars; ++k)
+                if (elem_truth[b * n_elem_vars + k])
+                    blk_vals[k].resize(n);
+            ++b;
         }
-        exo.write_coords(x, y);
     }
-    else if (dim == 3) {
-        std::vector<double> x(n_nodes, 0);
-        std::vector<double> y(n_nodes, 0);
-        std::vector<double> z(n_nodes, 0);
-        for (auto & [pt, idx] : node_map) {
-            x[idx] = pt.x;
-            y[idx] = pt.y;
-            z[idx] = pt.z;
+    // pending write of each buffer
+    std::vector<std::future<void>> written(buffers.size());
+    SerialQueue writer;
+    try {
+        for (std::size_t t = 0; t < steps.size(); ++t) {
+            // output steps are renumbered from 1
+            auto in_step = steps[t].step;
+            if (steps[t].segment != segment)
+                open_segment(steps[t].segment);
+            auto slot = t % buffers.size();
+            auto & buf = buffers[slot];
+            if (written[slot].valid())
+                written[slot].get();
+
+            for_each_ordered(
+                pool,
+                inputs.size(),
+                pool.size(),
+                [&](std::size_t fi) {
+                    StepValues vals;
+                    vals.nodal_mapped = mapped_nodal[fi];
+                    for (auto * var : vals.nodal_mapped)
+                        mapped[fi]->prefetch(*var, in_step - 1);
+                    auto lock = lock_io();
+                    if (vals.nodal_mapped.empty()) {
+                        vals.nodal.resize(n_nodal_vars);
+                        for (std::size_t k = 0; k < n_nodal_vars; ++k)
+                            vals.nodal[k] =
+                                inputs[fi]->get_nodal_variable_values(in_step, vars.nodal[k]);
+                    }
+                    if (n_elem_vars > 0) {
+                        for (auto & [blk_id, dest] : elem_dest[fi]) {
+                            auto & on = truth[segment][fi].at(blk_id);
+                            auto & blk_vals = vals.elem[blk_id];
+                            blk_vals.resize(n_elem_vars);
+                            for (std::size_t k = 0; k < n_elem_vars; ++k)
+                                if (on[k])
+                                    blk_vals[k] = inputs[fi]->get_elemental_variable_values(
+                                        in_step, vars.elem[k], blk_id);
+                        }
+                    }
+                    if (fi == 0 && !vars.global.empty()) {
+                        auto all = inputs[fi]->get_global_variable_values(in_step);
+                        for (auto idx : vars.global)
+                            vals.global.push_back(all[idx - 1]);
+                    }
+                    if (profile.enabled() || progress.enabled()) {
+                        uint64_t bytes = vals.global.size() * sizeof(double);
+                        for (auto & v : vals.nodal)
+                            bytes += v.size() * sizeof(double);
+                        for (auto * var : vals.nodal_mapped)
+                            bytes += var->n * (var->type == NC_TYPE_DOUBLE ? 8 : 4);
+                        for (auto & [blk_id, blk_vals] : vals.elem)
+                            for (auto & v : blk_vals)
+                                bytes += v.size() * sizeof(double);
+                        profile.count("read variables", bytes);
+                        progress.advance(0, bytes);
+                    }
+                    return vals;
+                },
+                [&](std::size_t fi, StepValues && vals) {
+                    auto timer = profile.scope("gather variables");
+                    if (vals.nodal_mapped.empty())
+                        copy_indexed(vals.nodal, plans[fi].src, plans[fi].dest, buf.nodal);
+                    for (std::size_t k = 0; k < vals.nodal_mapped.size(); ++k) {
+                        auto & var = *vals.nodal_mapped[k];
+                        if (var.type == NC_TYPE_DOUBLE)
+                            gather(mapped[fi]->array<double>(var, in_step - 1),
+                                   plans[fi],
+                                   buf.nodal[k]);
+                        else
+                            gather(mapped[fi]->array<float>(var, in_step - 1),
+                                   plans[fi],
+                                   buf.nodal[k]);
+                    }
+                    for (auto & [blk_id, blk_vals] : vals.elem) {
+                        auto & dest = elem_dest[fi].at(blk_id);
+                        auto absent = [](auto & v) { return v.empty(); };
+                        if (std::none_of(blk_vals.begin(), blk_vals.end(), absent))
+                            scatter(blk_vals, dest, buf.elem[blk_id]);
+                        else
+                            // positions of the input keep zeros for the variables it lacks
+                            for (std::size_t k = 0; k < blk_vals.size(); ++k)
+                                if (!blk_vals[k].empty())
+                                    scatter(blk_vals[k], dest, buf.elem[blk_id][k]);
+                    }
+                    if (fi == 0)
+                        buf.global = std::move(vals.global);
+                });
+
+            bool last = t + 1 == steps.size();
+            bool sync = last || (opts.sync_every > 0 && (t + 1) % opts.sync_every == 0);
+            int out_step = step_offset + t + 1;
+            auto time = steps[t].time;
+            written[slot] = writer.submit([&exo, &buf, out_step, time, sync] {
+                write_step(exo, out_step, time, buf, sync);
+            });
         }
-        exo.write_coords(x, y, z);
+        for (auto & f : written)
+            if (f.valid())
+                f.get();
     }
-    else
-        throw std::runtime_error(fmt::format("Unsupported dimension {}", dim));
+    catch (...) {
+        // pending writes reference the buffers
+        for (auto & f : written)
+            if (f.valid())
+                f.wait();
+        throw;
+    }
+}
+
+/// Key of the join map of a set of inputs
+///
+/// Hashes the mesh layout and nodal coordinates of all inputs together with the options that
+/// affect the node numbering, so the key changes whenever the numbering could.
+///
+/// @param pool Reader threads
+/// @param inputs Input file names
+/// @param headers Headers of the input files
+/// @param opts Join options
+/// @param int_size Size of IDs in bytes
+uint64_t
+join_map_key(ThreadPool & pool,
+             const std::vector<std::string> & inputs,
+             const std::vector<ExoHeader> & headers,
+             const JoinOptions & opts,
+             int int_size)
+{
+    uint64_t key = 0;
+    auto timer = profile.scope("join map key");
+    key = hash_value(key, int_size);
+    key = hash_value(key, opts.dedup);
+    key = hash_value(key, opts.reorder);
+    key = hash_value(key, opts.interface_only);
+    // the default tolerance follows from the coordinates, which are hashed below
+    key = hash_value(key, opts.tol);
+    for (auto & hdr : headers) {
+        auto sig = input_signature(hdr);
+        key = hash_value(key, sig.n_nodes);
+        key = hash_value(key, sig.n_elems);
+        key = hash_bytes(key, sig.blocks.data(), sig.blocks.size() * sizeof(InputSignature::Block));
+    }
+    for_each_ordered(
+        pool,
+        inputs.size(),
+        pool.size(),
+        [&](std::size_t i) {
+            auto lock = lock_io();
+            auto ex_in = open_input(inputs[i]);
+            ex_in->read_coords();
+            lock.unlock();
+            uint64_t h = 0;
+            profile.count("join map key", ex_in->get_num_nodes() * ex_in->get_dim() * 8);
+            h = hash_bytes(h, ex_in->get_x_coords().data(), ex_in->get_x_coords().size() * 8);
+            h = hash_bytes(h, ex_in->get_y_coords().data(), ex_in->get_y_coords().size() * 8);
+            if (ex_in->get_dim() == 3)
+                h = hash_bytes(h, ex_in->get_z_coords().data(), ex_in->get_z_coords().size() * 8);
+            return h;
+        },
+        [&](std::size_t, uint64_t && h) { key = hash_value(key, h); });
+    return key;
 }
 
+/// Put coordinates of an input file's nodes at their global IDs
+///
+/// @param ex x-coordinates of the input's nodes
+/// @param ey y-coordinates of the input's nodes
+/// @param ez z-coordinates of the input's nodes
+/// @param is Global node IDs (0-based) indexed by local node index
+/// @param placed Global node -> coordinates were placed. If given, only nodes not placed yet are
+///        set, so that the first input having a node supplies its coordinates
+template <typename INT, typename X, typename Y, typename Z>
 void
-write_elements(exodusIIcpp::File & exo,
-               const std::set<int64_t> & block_ids,
-               const std::map<int, ElementType> & block_element_type,
-               const std::map<int, std::vector<int>> & block_connect)
+place_coords(const X & ex,
+             const Y & ey,
+             const Z & ez,
+             const std::vector<INT> & is,
+             std::vector<double> & x,
+             std::vector<double> & y,
+             std::vector<double> & z,
+             std::vector<char> * placed = nullptr)
 {
-    for (auto blk_id : block_ids) {
-        int64_t n_elems_in_block = block_connect.at(blk_id).size() / num_nodes_per_elem[blk_id];
-        auto elem_type = element_type_str(block_element_type.at(blk_id));
-        exo.write_block(blk_id, elem_type, n_elems_in_block, block_connect.at(blk_id));
+    for (std::size_t i = 0; i < is.size(); ++i) {
+        if (placed) {
+            if ((*placed)[is[i]])
+                continue;
+            (*placed)[is[i]] = 1;
+        }
+        x[is[i]] = ex[i];
+        y[is[i]] = ey[i];
+        z[is[i]] = ez[i];
     }
 }
 
+/// Move elements of the output blocks to new positions
+///
+/// @param block_element_type Block ID -> element type
+/// @param block_connect Block ID -> connectivity array (1-based)
+/// @param from File index -> block ID -> current positions of the file's elements
+/// @param to File index -> block ID -> new positions of the file's elements
+template <typename INT>
 void
-write_nodal_variables(exodusIIcpp::File & exo,
-                      const std::map<int, std::vector<int>> & index_set,
-                      const std::vector<double> & times,
-                      std::size_t n_nodes,
-                      const std::vector<std::string> & var_names,
-                      const std::vector<NodalVariableValues> & var_values)
-{
-    exo.write_nodal_var_names(var_names);
-
-    std::vector<double> values(n_nodes);
-    for (auto t = 0; t < times.size(); ++t) {
-        exo.write_time(t + 1, times[t]);
-
-        for (int var_idx = 0; var_idx < var_names.size(); ++var_idx) {
-            for (auto fi = 0; fi < var_values.size(); ++fi) {
-                const auto & vals = var_values[fi][t][var_idx];
-                scatter(vals, index_set.at(fi), values);
+place_elements(const std::map<int64_t, ElementType> & block_element_type,
+               std::map<int64_t, std::vector<INT>> & block_connect,
+               const std::vector<std::map<int64_t, std::vector<INT>>> & from,
+               const std::vector<std::map<int64_t, std::vector<INT>>> & to)
+{
+    if (from == to)
+        return;
+    for (auto & [id, connect] : block_connect) {
+        std::vector<INT> placed(connect.size());
+        dispatch(block_element_type.at(id), [&](auto traits) {
+            for (std::size_t fi = 0; fi < from.size(); ++fi) {
+                auto it = from[fi].find(id);
+                if (it == from[fi].end())
+                    continue;
+                scatter_elements<decltype(traits)::N_NODES>(connect.data(),
+                                                            it->second,
+                                                            to[fi].at(id),
+                                                            placed.data());
             }
-            exo.write_nodal_var(t + 1, var_idx + 1, values);
-        }
+        });
+        std::swap(connect, placed);
+    }
+}
 
-        exo.update();
+/// Check that a cached join map was made from inputs with the meshes in `headers`
+template <typename INT>
+bool
+join_map_matches(const JoinMap<INT> & map, const std::vector<ExoHeader> & headers)
+{
+    if (map.inputs.size() != headers.size() || map.elem_dest.size() != headers.size())
+        return false;
+    for (std::size_t i = 0; i < headers.size(); ++i) {
+        if (!(map.inputs[i] == input_signature(headers[i])))
+            return false;
+        // the arrays are indexed by the inputs' nodes and elements
+        auto it = map.index_set.find(i);
+        if (it == map.index_set.end() ||
+            it->second.size() != static_cast<std::size_t>(headers[i].n_nodes))
+            return false;
+        for (auto & blk : headers[i].blocks) {
+            auto dest = map.elem_dest[i].find(blk.id);
+            if (dest == map.elem_dest[i].end() ||
+                dest->second.size() != static_cast<std::size_t>(blk.n_elems))
+                return false;
+        }
     }
+    return true;
 }
 
+/// Join input files
+///
+/// The mesh is joined from the inputs of the first segment, variables are taken from all segments
+/// along their merged time axis (see `merge_time_axes()`).
+///
+/// @tparam INT Type of global node and element IDs and connectivity entries
+/// @param segments Segment -> input file names
+/// @param segment_headers Segment -> headers of the input files
+/// @param output Output file name
+/// @param opts Join options
+template <typename INT>
 void
-join_files(const std::vector<std::string> & inputs, const std::string & output)
+join_files(const std::vector<std::vector<std::string>> & segments,
+           const std::vector<std::vector<ExoHeader>> & segment_headers,
+           const std::string & output,
+           const JoinOptions & opts)
 {
+    const auto & inputs = segments[0];
+    const auto & headers = segment_headers[0];
     // Spatial dimension
     int dim = -1;
-    // Mapping node coordinates into global index: Point -> Global ID (0-based)
-    std::map<Point, int> node_map;
+    // Unique nodes, global ID (0-based) is the insertion order
+    NodeDedup<INT> nodes(RELATIVE_TOLERANCE);
     /// file index -> global node IDs (0-based)
-    std::map<int, std::vector<int>> index_set;
+    std::map<int, std::vector<INT>> index_set;
     // Block IDs
     std::set<int64_t> block_ids;
     /// Block ID -> element type
-    std::map<int, ElementType> block_element_type;
+    std::map<int64_t, ElementType> block_element_type;
     // Elements per block: Block ID -> connectivity array (1-based)
-    std::map<int, std::vector<int>> block_connect;
-    // Nodal var names
-    std::vector<std::string> nodal_var_names;
-    // Nodal variable values per input file
-    std::vector<NodalVariableValues> nodal_vals(inputs.size());
-    // Time steps
-    std::vector<double> times;
+    std::map<int64_t, std::vector<INT>> block_connect;
+    // File index -> block ID -> position of the file's first element in the block
+    std::vector<std::map<int64_t, int64_t>> elem_offset;
+    // File index -> block ID -> output positions (0-based, within the block) of the file's elements
+    std::vector<std::map<int64_t, std::vector<INT>>> elem_dest(inputs.size());
+    // Node set ID -> (file index, local node index (0-based))
+    std::map<int, std::vector<std::pair<int, INT>>> node_sets;
+    // Side set ID -> entries
+    std::map<int, std::vector<SideEntry>> side_sets;
+    // Per input file: regions shared with other inputs
+    std::vector<std::vector<BoundingBox>> interfaces;
+    // Reader threads
+    ThreadPool pool(opts.n_jobs);
+    // Nodes in all inputs, the work of the phases that go through them
+    uint64_t n_input_nodes = 0;
+    for (auto & hdr : headers)
+        n_input_nodes += hdr.n_nodes;
+    // Time steps to join, checked before any real work is done
+    std::vector<StepSource> steps;
+    {
+        auto timer = profile.scope("time axis");
+        auto axis = merge_time_axes(pool, segments, segment_headers);
+        for (auto s : opts.times.steps(axis.size()))
+            steps.push_back(axis[s - 1]);
+    }
+    // Node numbering and element placement from an earlier join of the same inputs
+    std::optional<JoinMap<INT>> cached;
+    std::string cache_file;
+    if (!opts.map_cache.empty()) {
+        auto key = join_map_key(pool, inputs, headers, opts, sizeof(INT));
+        cache_file = fmt::format("{}/{:016x}.jmap", opts.map_cache, key);
+        if (std::filesystem::exists(cache_file)) {
+            auto timer = profile.scope("read join map");
+            // a map that cannot be read (e.g. truncated by a crash) is a miss, it gets rewritten
+            try {
+                cached = read_join_map<INT>(cache_file);
+            }
+            catch (std::exception &) {
+                cached.reset();
+            }
+            if (cached && !join_map_matches(*cached, headers))
+                cached.reset();
+        }
+    }
+    // Coordinates of global nodes, when numbered by `cached` or by the external dedup
+    std::vector<double> cx, cy, cz;
+    // Global node -> coordinates were placed, for the external dedup
+    std::vector<char> placed;
+    if (cached) {
+        cx.resize(cached->n_nodes);
+        cy.resize(cached->n_nodes);
+        cz.resize(cached->n_nodes, 0.);
+    }
+
+    // Snap tolerance, the default is set from the first input's coordinates once they are read
+    double tol = opts.tol;
+    if (opts.interface_only && !cached) {
+        auto timer = profile.scope("bounding boxes");
+        progress.phase("bounding boxes", inputs.size(), "files");
+        std::vector<std::future<BoundingBox>> bboxes;
+        for (auto & input : inputs)
+            bboxes.push_back(pool.submit([&input] {
+                auto lock = lock_io();
+                exodusIIcpp::File ex_in(input, exodusIIcpp::FileAccess::READ);
+                ex_in.init();
+                ex_in.read_coords();
+                return read_bounding_box(ex_in, ex_in.get_dim());
+            }));
+        std::vector<BoundingBox> bbox;
+        for (auto & f : bboxes) {
+            bbox.push_back(f.get());
+            progress.advance(1);
+        }
+        tol = snap_tolerance(opts, bbox[0]);
+        interfaces = find_interfaces(bbox, tol);
+    }
+    if (tol > 0)
+        nodes = NodeDedup<INT>(tol);
 
-    // read data
-    for (int i = 0; i < inputs.size(); ++i) {
-        exodusIIcpp::File ex_in(inputs[i], exodusIIcpp::FileAccess::READ);
-        ex_in.init();
-
-        dim = ex_in.get_dim();
-
-        ex_in.read_blocks();
-        read_block_ids(ex_in, block_ids);
-        block_element_type = read_element_types(ex_in);
-        index_set[i] = read_file(ex_in, dim, node_map);
-        auto blocks = read_elements(ex_in);
-        for (auto & [id, connect] : blocks) {
-            remap_connectivity(connect, index_set[i]);
-            block_connect[id].insert(block_connect[id].end(), connect.begin(), connect.end());
+    if (opts.dedup == Dedup::SORT && !cached) {
+        // gather coordinates of all inputs, number them all at once
+        auto timer = profile.scope("sort dedup");
+        progress.phase("sort dedup", n_input_nodes, "nodes");
+        std::vector<double> x, y, z;
+        std::vector<std::size_t> offsets = { 0 };
+        for_each_ordered(
+            pool,
+            inputs.size(),
+            pool.size(),
+            [&](std::size_t i) {
+                auto lock = lock_io();
+                auto ex_in = open_input(inputs[i]);
+                ex_in->read_coords();
+                return ex_in;
+            },
+            [&](std::size_t, InputFile && ex_in) {
+                append_coords(*ex_in, ex_in->get_dim(), x, y, z);
+                offsets.push_back(x.size());
+                progress.advance(ex_in->get_num_nodes(),
+                                 ex_in->get_num_nodes() * ex_in->get_dim() * sizeof(double));
+            });
+        if (tol == 0) {
+            BoundingBox first_bbox;
+            for (std::size_t k = 0; k < offsets[1]; ++k)
+                first_bbox.expand(x[k], y[k], z[k]);
+            tol = snap_tolerance(opts, first_bbox);
         }
+        auto ids = sort_dedup(pool, x, y, z, tol, nodes);
+        profile.count("sort dedup", 3 * x.size() * sizeof(double), 0, x.size(), "nodes");
+        for (std::size_t i = 0; i < inputs.size(); ++i)
+            index_set[i].assign(ids.begin() + offsets[i], ids.begin() + offsets[i + 1]);
+    }
+
+    if (opts.dedup == Dedup::EXTERNAL && !cached) {
+        // only the records within the memory budget are held, coordinates are read again when
+        // the mesh is loaded and put at their global IDs then
+        auto timer = profile.scope("external dedup");
+        progress.phase("external dedup", n_input_nodes, "nodes");
+        // created for the first input, which sets the default tolerance
+        std::optional<ExternalDedup<INT>> ext;
+        uint64_t n_points = 0;
+        for_each_ordered(
+            pool,
+            inputs.size(),
+            pool.size(),
+            [&](std::size_t i) {
+                auto lock = lock_io();
+                auto ex_in = open_input(inputs[i]);
+                ex_in->read_coords();
+                return ex_in;
+            },
+            [&](std::size_t i, InputFile && ex_in) {
+                auto & exo = *ex_in;
+                if (i == 0) {
+                    if (tol == 0)
+                        tol = snap_tolerance(opts, read_bounding_box(exo, exo.get_dim()));
+                    ext.emplace(tol, opts.mem_limit, opts.scratch_dir);
+                }
+                if (exo.get_dim() == 3)
+                    ext->add(exo.get_x_coords(), exo.get_y_coords(), exo.get_z_coords());
+                else
+                    ext->add(exo.get_x_coords(), exo.get_y_coords(), ZeroCoords());
+                n_points += exo.get_num_nodes();
+                progress.advance(exo.get_num_nodes(),
+                                 exo.get_num_nodes() * exo.get_dim() * sizeof(double));
+            });
+        auto n_unique = ext->finish(index_set);
+        profile.count("external dedup", ext->spilled(), ext->spilled(), n_points, "nodes");
+        cx.resize(n_unique);
+        cy.resize(n_unique);
+        cz.resize(n_unique, 0.);
+        placed.assign(n_unique, 0);
+    }
+
+    // size the output blocks from the file headers, so that connectivity can be read straight
+    // into its final place
+    auto block_n_elems = layout_blocks(headers, block_ids, block_element_type, elem_offset);
+    for (auto & [id, n] : block_n_elems)
+        block_connect[id].resize(static_cast<std::size_t>(n) * num_nodes_per_elem[id]);
+
+    // read mesh: files are loaded on the reader threads, but numbered in input order on this
+    // thread, so the global numbering does not depend on the number of threads
+    auto read_timer = profile.scope("read mesh");
+    progress.phase("read mesh", n_input_nodes, "nodes");
+    for_each_ordered(
+        pool,
+        inputs.size(),
+        pool.size(),
+        [&](std::size_t i) {
+            auto mesh = load_input(inputs[i], cached || opts.dedup != Dedup::SORT, opts.mmap);
+            read_connectivity(
+                inputs[i], headers[i], elem_offset[i], block_connect, mesh.mapped.get());
+            if (profile.enabled() || progress.enabled()) {
+                auto & hdr = headers[i];
+                bool coords = cached || opts.dedup != Dedup::SORT;
+                uint64_t bytes = coords ? hdr.n_nodes * hdr.dim * sizeof(double) : 0;
+                for (auto & blk : hdr.blocks)
+                    bytes += blk.n_elems * blk.n_nodes_per_elem * sizeof(INT);
+                profile.count("read mesh", bytes);
+                progress.advance(0, bytes);
+            }
+            return mesh;
+        },
+        [&](std::size_t i, InputMesh && mesh) {
+            auto & ex_in = *mesh.exo;
+            dim = ex_in.get_dim();
+
+            if (cached) {
+                index_set[i] = std::move(cached->index_set.at(i));
+                with_coords(mesh, dim, [&](const auto & x, const auto & y, const auto & z) {
+                    place_coords(x, y, z, index_set[i], cx, cy, cz);
+                });
+            }
+            else if (opts.dedup == Dedup::EXTERNAL) {
+                with_coords(mesh, dim, [&](const auto & x, const auto & y, const auto & z) {
+                    place_coords(x, y, z, index_set[i], cx, cy, cz, &placed);
+                });
+            }
+            else if (opts.dedup == Dedup::HASH) {
+                auto timer = profile.scope("dedup");
+                auto * interface = opts.interface_only ? &interfaces[i] : nullptr;
+                with_coords(mesh, dim, [&](const auto & x, const auto & y, const auto & z) {
+                    if (i == 0 && tol == 0) {
+                        tol = snap_tolerance(opts, bounding_box(x, y, z));
+                        nodes = NodeDedup<INT>(tol);
+                    }
+                    index_set[i] = read_file(x, y, z, nodes, interface);
+                });
+                profile.count("dedup", 0, 0, index_set[i].size(), "nodes");
+            }
+            auto remap_timer = profile.scope("remap connectivity");
+            for (auto & blk : headers[i].blocks) {
+                auto nn = blk.n_nodes_per_elem;
+                auto first = elem_offset[i][blk.id];
+                remap_connectivity(
+                    block_connect[blk.id].data() + first * nn, blk.n_elems * nn, index_set[i]);
 
-        // TODO: even check var names...
-        nodal_var_names = ex_in.get_nodal_variable_names();
+                auto & dest = elem_dest[i][blk.id];
+                dest.resize(blk.n_elems);
+                std::iota(dest.begin(), dest.end(), first);
+                profile.count("remap connectivity", 0, 0, blk.n_elems * nn, "entries");
+            }
+            remap_timer.stop();
+
+            for (auto & ns : ex_in.get_node_sets()) {
+                auto & entries = node_sets[ns.get_id()];
+                for (auto n : ns.get_node_ids())
+                    entries.emplace_back(i, n - 1);
+            }
+
+            ElementLocator locator(headers[i]);
+            for (auto & ss : ex_in.get_side_sets()) {
+                auto & entries = side_sets[ss.get_id()];
+                const auto & elems = ss.get_element_ids();
+                const auto & sides = ss.get_side_ids();
+                for (std::size_t k = 0; k < elems.size(); ++k) {
+                    auto [blk_id, idx] = locator.locate(elems[k] - 1);
+                    check_side(ss.get_id(), blk_id, block_element_type.at(blk_id), sides[k]);
+                    entries.push_back({ static_cast<int>(i), blk_id, idx, sides[k] });
+                }
+            }
 
-        ex_in.read_times();
-        // TODO: check that files have the same number of time steps
-        times = ex_in.get_times();
+            progress.advance(headers[i].n_nodes);
+        });
+    read_timer.stop();
 
-        nodal_vals[i] = read_nodal_vals(ex_in);
+    if (opts.dedup == Dedup::EXTERNAL && !cached) {
+        placed = {};
+        nodes.assign(std::move(cx), std::move(cy), std::move(cz));
+    }
+    if (cached) {
+        nodes.assign(std::move(cx), std::move(cy), std::move(cz));
+        place_elements(block_element_type, block_connect, elem_dest, cached->elem_dest);
+        elem_dest = std::move(cached->elem_dest);
+    }
+    else if (opts.reorder != Reorder::NONE) {
+        auto timer = profile.scope("reorder");
+        progress.phase("reorder", 1, "meshes");
+        reorder_mesh(opts.reorder, nodes, block_element_type, index_set, block_connect, elem_dest);
+        progress.advance(1);
     }
 
     // write
-    exodusIIcpp::File ex_out(output, exodusIIcpp::FileAccess::WRITE);
+    auto write_timer = profile.scope("write mesh");
+    progress.phase("write mesh", 1, "meshes");
+    auto write_lock = lock_io();
+    ExoWriter ex_out(output, sizeof(INT) == 8, opts.compression, opts.compression_level);
 
-    auto n_nodes = node_map.size();
+    auto n_nodes = nodes.size();
     int64_t n_elems = 0;
     for (auto blk_id : block_ids)
         n_elems += block_connect[blk_id].size() / num_nodes_per_elem[blk_id];
     int n_elem_blks = block_connect.size();
-    int n_node_sets = 0;
-    int n_side_sets = 0;
+    int n_node_sets = node_sets.size();
+    int n_side_sets = side_sets.size();
     ex_out.init("", dim, n_nodes, n_elems, n_elem_blks, n_node_sets, n_side_sets);
 
-    write_nodes(ex_out, dim, node_map);
+    write_nodes(ex_out, dim, nodes);
     write_elements(ex_out, block_ids, block_element_type, block_connect);
-    write_nodal_variables(ex_out, index_set, times, n_nodes, nodal_var_names, nodal_vals);
+    write_node_sets(ex_out, node_sets, index_set);
+    write_side_sets(ex_out, side_sets, elem_dest, block_ids, block_connect);
+    write_lock.unlock();
+    if (profile.enabled() || progress.enabled()) {
+        uint64_t bytes = n_nodes * dim * sizeof(double);
+        for (auto & [id, connect] : block_connect)
+            bytes += connect.size() * sizeof(INT);
+        profile.count("write mesh", 0, bytes);
+        progress.advance(1, bytes);
+    }
+    write_timer.stop();
+
+    bool save_cache = !cache_file.empty() && !cached;
+    if (opts.append || save_cache) {
+        auto timer = profile.scope("write join map");
+        JoinMap<INT> map;
+        for (auto & hdr : headers)
+            map.inputs.push_back(input_signature(hdr));
+        map.n_nodes = n_nodes;
+        map.block_n_elems = block_n_elems;
+        map.index_set = index_set;
+        map.elem_dest = elem_dest;
+        if (opts.append)
+            write_join_map(join_map_filename(output), map);
+        if (save_cache) {
+            std::filesystem::create_directories(opts.map_cache);
+            write_join_map(cache_file, map);
+        }
+    }
+
+    auto plans = build_gather_plans(index_set, n_nodes);
+    VariableNames var_names { headers[0].nodal_var_names,
+                              headers[0].elem_var_names,
+                              headers[0].global_var_names };
+    auto vars = select_variables(var_names, opts.vars);
+    auto truth = read_elem_truth(pool, segments, segment_headers, vars);
+    auto elem_truth = join_elem_truth(truth, block_n_elems, vars.elem.size());
+    write_variable_names(ex_out, vars.names, block_n_elems.size(), elem_truth);
+    // inputs are opened again for the variables, so they do not hold on to their geometry
+    auto timer = profile.scope("variables");
+    write_variables(ex_out,
+                    pool,
+                    segments,
+                    plans,
+                    elem_dest,
+                    block_n_elems,
+                    truth,
+                    elem_truth,
+                    steps,
+                    0,
+                    n_nodes,
+                    vars,
+                    opts);
+}
+
+/// Append time steps newer than the last one in an existing joined output
+///
+/// Node numbering and element placement are taken from the join map saved with the output, so
+/// the geometry of the inputs is not read at all.
+///
+/// @param segments Segment -> input file names
+/// @param segment_headers Segment -> headers of the input files
+/// @param output Joined file name
+/// @param opts Join options
+template <typename INT>
+void
+append_files(const std::vector<std::vector<std::string>> & segments,
+             const std::vector<std::vector<ExoHeader>> & segment_headers,
+             const std::string & output,
+             const JoinOptions & opts)
+{
+    const auto & inputs = segments[0];
+    const auto & headers = segment_headers[0];
+    auto map = read_join_map<INT>(join_map_filename(output));
+    if (map.inputs.size() != headers.size())
+        throw std::runtime_error(fmt::format("'{}' was joined from {} files, not {}",
+                                             output,
+                                             map.inputs.size(),
+                                             headers.size()));
+    for (std::size_t i = 0; i < headers.size(); ++i)
+        if (!(map.inputs[i] == input_signature(headers[i])))
+            throw std::runtime_error(
+                fmt::format("Mesh of '{}' does not match the one joined into '{}'",
+                            inputs[i],
+                            output));
+
+    auto write_lock = lock_io();
+    auto ex_out = ExoWriter::append(output);
+    if (ex_out.num_nodes() != map.n_nodes)
+        throw std::runtime_error(fmt::format("'{}' does not match its join map", output));
+    int n_out_times = ex_out.num_times();
+    double last_time = n_out_times > 0 ? ex_out.time(n_out_times)
+                                       : std::numeric_limits<double>::lowest();
+    VariableNames out_names { ex_out.variable_names(EX_NODAL),
+                              ex_out.variable_names(EX_ELEM_BLOCK),
+                              ex_out.variable_names(EX_GLOBAL) };
+    write_lock.unlock();
+
+    VariableNames var_names { headers[0].nodal_var_names,
+                              headers[0].elem_var_names,
+                              headers[0].global_var_names };
+    auto vars = select_variables(var_names, opts.vars);
+    if (vars.names.nodal != out_names.nodal || vars.names.elem != out_names.elem ||
+        vars.names.global != out_names.global)
+        throw std::runtime_error(
+            fmt::format("Variables to join do not match the ones in '{}'", output));
+
+    ThreadPool pool(opts.n_jobs);
+    std::vector<StepSource> axis;
+    {
+        auto timer = profile.scope("time axis");
+        axis = merge_time_axes(pool, segments, segment_headers);
+    }
+    std::vector<StepSource> steps;
+    for (auto s : opts.times.steps(axis.size()))
+        if (axis[s - 1].time > last_time)
+            steps.push_back(axis[s - 1]);
+
+    // new segments must not put element variables on blocks the output has none of, the ones
+    // they lack are written as zeros
+    auto truth = read_elem_truth(pool, segments, segment_headers, vars);
+    auto elem_truth = join_elem_truth(truth, map.block_n_elems, vars.elem.size());
+    std::vector<int> out_truth;
+    {
+        auto lock = lock_io();
+        out_truth = ex_out.elem_truth_table(map.block_n_elems.size(), vars.elem.size());
+    }
+    for (std::size_t k = 0; k < elem_truth.size(); ++k)
+        if (elem_truth[k] && !out_truth[k])
+            throw std::runtime_error(fmt::format(
+                "Element variables of the inputs are on blocks that have none in '{}'", output));
+
+    auto plans = build_gather_plans(map.index_set, map.n_nodes);
+    auto timer = profile.scope("variables");
+    write_variables(ex_out,
+                    pool,
+                    segments,
+                    plans,
+                    map.elem_dest,
+                    map.block_n_elems,
+                    truth,
+                    out_truth,
+                    steps,
+                    n_out_times,
+                    map.n_nodes,
+                    vars,
+                    opts);
+}
+
+/// Check that all inputs have the variables of the first one, in the same order
+///
+/// Variables are picked by their index in the first input, and read by that index from all of
+/// them.
+void
+check_variable_names(const std::vector<std::string> & inputs,
+                     const std::vector<ExoHeader> & headers)
+{
+    auto & first = headers[0];
+    auto check = [&](std::size_t i,
+                     const char * kind,
+                     const std::vector<std::string> & names,
+                     const std::vector<std::string> & first_names) {
+        if (names != first_names)
+            throw std::runtime_error(fmt::format(
+                "{} variables of '{}' do not match the ones of '{}'", kind, inputs[i], inputs[0]));
+    };
+    for (std::size_t i = 1; i < headers.size(); ++i) {
+        check(i, "Nodal", headers[i].nodal_var_names, first.nodal_var_names);
+        check(i, "Element", headers[i].elem_var_names, first.elem_var_names);
+        check(i, "Global", headers[i].global_var_names, first.global_var_names);
+    }
+}
+
+/// Check if joining the inputs needs 64-bit IDs
+///
+/// That is the case when any input stores 64-bit integers, or when the joined mesh would have
+/// more nodes, elements or connectivity entries in a block than fit into an `int`.
+bool
+needs_int64(const std::vector<ExoHeader> & headers)
+{
+    constexpr int64_t INT_LIMIT = std::numeric_limits<int>::max();
+    int64_t n_nodes = 0;
+    int64_t n_elems = 0;
+    std::map<int64_t, int64_t> block_n_entries;
+    for (auto & hdr : headers) {
+        if (hdr.int64)
+            return true;
+        n_nodes += hdr.n_nodes;
+        n_elems += hdr.n_elems;
+        for (auto & blk : hdr.blocks)
+            block_n_entries[blk.id] += blk.n_elems * blk.n_nodes_per_elem;
+    }
+    if (n_nodes > INT_LIMIT || n_elems > INT_LIMIT)
+        return true;
+    for (auto & [id, n] : block_n_entries)
+        if (n > INT_LIMIT)
+            return true;
+    return false;
+}
+
+void
+join_files(const std::vector<std::string> & inputs,
+           const std::string & output,
+           const JoinOptions & opts)
+{
+    std::vector<ExoHeader> headers;
+    {
+        auto timer = profile.scope("read headers");
+        ThreadPool pool(opts.n_jobs);
+        headers = read_headers(pool, inputs);
+    }
+
+    // segments follow each other on the command line, each with the same parts of the mesh
+    if (opts.segments < 1 || inputs.size() % opts.segments != 0)
+        throw std::runtime_error(
+            fmt::format("Cannot split {} inputs into {} segments", inputs.size(), opts.segments));
+    auto n_parts = inputs.size() / opts.segments;
+    std::vector<std::vector<std::string>> segments;
+    std::vector<std::vector<ExoHeader>> segment_headers;
+    for (std::size_t i = 0; i < inputs.size(); i += n_parts) {
+        segments.emplace_back(inputs.begin() + i, inputs.begin() + i + n_parts);
+        segment_headers.emplace_back(headers.begin() + i, headers.begin() + i + n_parts);
+    }
+    for (std::size_t s = 1; s < segments.size(); ++s)
+        for (std::size_t i = 0; i < n_parts; ++i) {
+            auto & hdr = segment_headers[s][i];
+            auto & first = segment_headers[0][i];
+            if (!(input_signature(hdr) == input_signature(first)))
+                throw std::runtime_error(fmt::format("Mesh of '{}' does not match the one of '{}'",
+                                                     segments[s][i],
+                                                     segments[0][i]));
+        }
+    check_variable_names(inputs, headers);
+
+    if (opts.append && std::filesystem::exists(output)) {
+        // IDs have the size the output was joined with
+        if (join_map_int_size(join_map_filename(output)) == sizeof(int64_t))
+            append_files<int64_t>(segments, segment_headers, output, opts);
+        else
+            append_files<int>(segments, segment_headers, output, opts);
+    }
+    // 32-bit IDs keep the arrays compact, so use them whenever they suffice
+    else if (needs_int64(segment_headers[0]))
+        join_files<int64_t>(segments, segment_headers, output, opts);
+    else
+        join_files<int>(segments, segment_headers, output, opts);
+}
+
+#ifdef EXODUSII_UTILS_MPI
+
+/// Join input files on all ranks of `comm`
+///
+/// Each rank reads the inputs `first` through `last - 1`, so its elements form one contiguous slice
+/// of every output block. Nodes are numbered by `distributed_dedup()`: only points on interfaces
+/// between ranks travel, and each rank owns a contiguous range of the global node IDs. All ranks
+/// then write their nodes, element slices and variables into the output collectively. Node sets,
+/// time values and global variables are assembled on rank 0.
+///
+/// The inputs are a single segment (restarts are not merged), so all of them must have the time
+/// steps of the first one.
+///
+/// @tparam INT Type of global node and element IDs and connectivity entries
+/// @param comm Communicator
+/// @param inputs Input file names (all of them)
+/// @param first First input read by this rank
+/// @param last One past the last input read by this rank
+/// @param headers Headers of all input files
+/// @param output Output file name
+/// @param opts Join options
+template <typename INT>
+void
+join_files_mpi(MPI_Comm comm,
+               const std::vector<std::string> & inputs,
+               std::size_t first,
+               std::size_t last,
+               const std::vector<ExoHeader> & headers,
+               const std::string & output,
+               const JoinOptions & opts)
+{
+    int rank = mpi_rank(comm);
+    int dim = headers[0].dim;
+    // Block IDs
+    std::set<int64_t> block_ids;
+    /// Block ID -> element type
+    std::map<int64_t, ElementType> block_element_type;
+    // File index -> block ID -> position of the file's first element in the block
+    std::vector<std::map<int64_t, int64_t>> elem_offset;
+    auto block_n_elems = layout_blocks(headers, block_ids, block_element_type, elem_offset);
+
+    // ID of the first element of each block in the output (0-based)
+    std::map<int64_t, int64_t> block_start;
+    int64_t n_elems = 0;
+    for (auto id : block_ids) {
+        block_start[id] = n_elems;
+        n_elems += block_n_elems[id];
+    }
+    // This rank's slice of each block: block ID -> first element, number of elements
+    std::map<int64_t, int64_t> slice_start, slice_n;
+    for (std::size_t i = 0; i < last; ++i)
+        for (auto & blk : headers[i].blocks) {
+            if (i < first)
+                slice_start[blk.id] += blk.n_elems;
+            else
+                slice_n[blk.id] += blk.n_elems;
+        }
+    // File index -> block ID -> position of the file's first element in this rank's slice
+    std::vector<std::map<int64_t, int64_t>> local_offset(headers.size());
+    for (std::size_t i = first; i < last; ++i)
+        for (auto & [id, offset] : elem_offset[i])
+            local_offset[i][id] = offset - slice_start[id];
+    // Block ID -> connectivity of this rank's slice (1-based)
+    std::map<int64_t, std::vector<INT>> block_connect;
+    for (auto id : block_ids)
+        block_connect[id].resize(static_cast<std::size_t>(slice_n[id]) * num_nodes_per_elem[id]);
+
+    // Side set ID -> position of this rank's first entry, number of entries in the set
+    std::map<int64_t, int64_t> side_set_start, side_set_n;
+    // Node set IDs
+    std::set<int64_t> node_set_ids;
+    for (std::size_t i = 0; i < headers.size(); ++i) {
+        for (auto & ss : headers[i].side_sets) {
+            side_set_n[ss.id] += ss.size;
+            if (i < first)
+                side_set_start[ss.id] += ss.size;
+        }
+        for (auto & ns : headers[i].node_sets)
+            node_set_ids.insert(ns.id);
+    }
+
+    // Points of this rank's inputs, one input after another
+    std::vector<double> x, y, z;
+    std::vector<std::size_t> offsets = { 0 };
+    // Node set ID -> local point indices (0-based)
+    std::map<int64_t, std::vector<std::size_t>> node_set_points;
+    // Side set ID -> output element IDs (1-based) and sides
+    std::map<int64_t, std::vector<INT>> side_set_elems, side_set_sides;
+    // Time steps of this rank's first input
+    std::vector<double> times;
+    // First of this rank's inputs with other time steps than that (`inputs.size()` if none)
+    uint64_t bad_times = inputs.size();
+    ThreadPool pool(opts.n_jobs);
+    auto read_timer = profile.scope("read mesh");
+    // progress is reported by rank 0, for its own inputs
+    uint64_t n_local_nodes = 0;
+    for (std::size_t i = first; i < last; ++i)
+        n_local_nodes += headers[i].n_nodes;
+    progress.phase("read mesh", n_local_nodes, "nodes");
+    for_each_ordered(
+        pool,
+        last - first,
+        pool.size(),
+        [&](std::size_t k) {
+            auto i = first + k;
+            auto mesh = load_input(inputs[i], true, opts.mmap);
+            read_connectivity(
+                inputs[i], headers[i], local_offset[i], block_connect, mesh.mapped.get());
+            if (profile.enabled() || progress.enabled()) {
+                uint64_t bytes = headers[i].n_nodes * dim * sizeof(double);
+                for (auto & blk : headers[i].blocks)
+                    bytes += blk.n_elems * blk.n_nodes_per_elem * sizeof(INT);
+                profile.count("read mesh", bytes);
+                progress.advance(0, bytes);
+            }
+            return mesh;
+        },
+        [&](std::size_t k, InputMesh && mesh) {
+            auto i = first + k;
+            with_coords(mesh, dim, [&](const auto & ex, const auto & ey, const auto & ez) {
+                for (std::size_t n = 0; n < ex.size(); ++n) {
+                    x.push_back(ex[n]);
+                    y.push_back(ey[n]);
+                    z.push_back(ez[n]);
+                }
+            });
+            offsets.push_back(x.size());
+            progress.advance(headers[i].n_nodes);
+
+            for (auto & ns : mesh.exo->get_node_sets()) {
+                auto & points = node_set_points[ns.get_id()];
+                for (auto n : ns.get_node_ids())
+                    points.push_back(offsets[k] + n - 1);
+            }
+
+            ElementLocator locator(headers[i]);
+            for (auto & ss : mesh.exo->get_side_sets()) {
+                auto & elems = side_set_elems[ss.get_id()];
+                auto & sides = side_set_sides[ss.get_id()];
+                const auto & ss_elems = ss.get_element_ids();
+                const auto & ss_sides = ss.get_side_ids();
+                for (std::size_t j = 0; j < ss_elems.size(); ++j) {
+                    auto [blk_id, idx] = locator.locate(ss_elems[j] - 1);
+                    check_side(ss.get_id(), blk_id, block_element_type.at(blk_id), ss_sides[j]);
+                    auto pos = elem_offset[i][blk_id] + idx;
+                    elems.push_back(block_start[blk_id] + pos + 1);
+                    sides.push_back(ss_sides[j]);
+                }
+            }
+
+            if (k == 0)
+                times = mesh.times;
+            else if (mesh.times != times && bad_times == inputs.size())
+                bad_times = i;
+        });
+    read_timer.stop();
+    // all inputs are parts of one mesh, so every rank's steps must be the ones of rank 0
+    auto local_times = times;
+    broadcast(comm, times);
+    if (local_times != times)
+        bad_times = first;
+    detail::check_mpi(
+        MPI_Allreduce(MPI_IN_PLACE, &bad_times, 1, MPI_UINT64_T, MPI_MIN, comm), "MPI_Allreduce");
+    if (bad_times < inputs.size())
+        throw std::runtime_error(fmt::format(
+            "'{}' has different time steps than '{}'", inputs[bad_times], inputs[0]));
+
+    auto dedup_timer = profile.scope("dedup");
+    double tol = opts.tol;
+    if (tol == 0) {
+        // the first input is rank 0's
+        if (rank == 0) {
+            BoundingBox bbox;
+            for (std::size_t k = 0; k < offsets[1]; ++k)
+                bbox.expand(x[k], y[k], z[k]);
+            tol = snap_tolerance(opts, bbox);
+        }
+        detail::check_mpi(MPI_Bcast(&tol, 1, MPI_DOUBLE, 0, comm), "MPI_Bcast");
+    }
+    // checked up front, so that all ranks stop together rather than one in the middle of the dedup
+    double max_abs = 0;
+    for (std::size_t k = 0; k < x.size(); ++k)
+        max_abs = std::max({ max_abs, std::fabs(x[k]), std::fabs(y[k]), std::fabs(z[k]) });
+    detail::check_mpi(MPI_Allreduce(MPI_IN_PLACE, &max_abs, 1, MPI_DOUBLE, MPI_MAX, comm),
+                      "MPI_Allreduce");
+    check_snap_range(max_abs, tol);
+    auto dn = distributed_dedup<INT>(comm, x, y, z, tol);
+    profile.count("dedup", 0, 0, x.size(), "nodes");
+    dedup_timer.stop();
+    auto n_points = x.size();
+    x = {};
+    y = {};
+    z = {};
+
+    auto remap_timer = profile.scope("remap connectivity");
+    for (std::size_t i = first; i < last; ++i) {
+        auto k = i - first;
+        std::vector<INT> is(dn.ids.begin() + offsets[k], dn.ids.begin() + offsets[k + 1]);
+        for (auto & blk : headers[i].blocks) {
+            auto nn = blk.n_nodes_per_elem;
+            remap_connectivity(block_connect[blk.id].data() + local_offset[i][blk.id] * nn,
+                               blk.n_elems * nn,
+                               is);
+            profile.count("remap connectivity", 0, 0, blk.n_elems * nn, "entries");
+        }
+    }
+    remap_timer.stop();
+
+    // interface nodes are in a node set once per input that has them, so sets are merged on
+    // rank 0
+    std::map<int64_t, std::vector<INT>> node_sets;
+    for (auto id : node_set_ids) {
+        std::vector<INT> ids;
+        for (auto pt : node_set_points[id])
+            ids.push_back(dn.ids[pt] + 1);
+        ids = gather(comm, ids);
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+        node_sets[id] = std::move(ids);
+    }
+    std::vector<int64_t> node_set_sizes;
+    for (auto & [id, ids] : node_sets)
+        node_set_sizes.push_back(ids.size());
+    broadcast(comm, node_set_sizes);
+
+    auto write_timer = profile.scope("write mesh");
+    ExoWriter ex_out(comm, output, sizeof(INT) == 8);
+    ex_out.init("",
+                dim,
+                dn.n_global,
+                n_elems,
+                block_ids.size(),
+                node_set_ids.size(),
+                side_set_n.size());
+    ex_out.write_partial_coords(dn.first + 1, dn.x, dn.y, dim == 3 ? &dn.z : nullptr);
+    for (auto id : block_ids)
+        ex_out.write_partial_block(id,
+                                   exodus_element_name(block_element_type.at(id)),
+                                   block_n_elems[id],
+                                   num_nodes_per_elem[id],
+                                   slice_start[id] + 1,
+                                   block_connect[id]);
+    std::size_t ns = 0;
+    for (auto & [id, ids] : node_sets)
+        ex_out.write_partial_node_set(id, node_set_sizes[ns++], 1, ids);
+    for (auto & [id, n] : side_set_n)
+        ex_out.write_partial_side_set(
+            id, n, side_set_start[id] + 1, side_set_elems[id], side_set_sides[id]);
+    if (profile.enabled()) {
+        uint64_t bytes = dn.n_owned() * dim * sizeof(double);
+        for (auto & [id, connect] : block_connect)
+            bytes += connect.size() * sizeof(INT);
+        profile.count("write mesh", 0, bytes);
+    }
+    block_connect.clear();
+    write_timer.stop();
+
+    auto & hdr = headers[0];
+    auto vars = select_variables(
+        VariableNames { hdr.nodal_var_names, hdr.elem_var_names, hdr.global_var_names }, opts.vars);
+    // each rank reads the truth of its own inputs
+    std::vector<std::vector<ElemTruth>> truth(1);
+    for (std::size_t i = first; i < last; ++i)
+        truth[0].push_back(read_elem_truth(inputs[i], headers[i], vars));
+    auto elem_truth = join_elem_truth(truth, block_n_elems, vars.elem.size());
+    if (!elem_truth.empty())
+        detail::check_mpi(MPI_Allreduce(MPI_IN_PLACE,
+                                        elem_truth.data(),
+                                        elem_truth.size(),
+                                        MPI_INT,
+                                        MPI_MAX,
+                                        comm),
+                          "MPI_Allreduce");
+    write_variable_names(ex_out, vars.names, block_ids.size(), elem_truth);
+
+    auto timer = profile.scope("variables");
+    std::vector<InputFile> ex_ins;
+    for (std::size_t i = first; i < last; ++i)
+        ex_ins.push_back(open_input(inputs[i]));
+    auto steps = opts.times.steps(times.size());
+    progress.phase("variables", steps.size(), "steps");
+    std::vector<double> local(n_points);
+    std::vector<double> owned;
+    std::map<int64_t, std::vector<double>> elem_vals;
+    for (std::size_t t = 0; t < steps.size(); ++t) {
+        auto in_step = steps[t];
+        int out_step = t + 1;
+        ex_out.write_time(out_step, times[in_step - 1]);
+        for (std::size_t v = 0; v < vars.nodal.size(); ++v) {
+            for (std::size_t k = 0; k < ex_ins.size(); ++k) {
+                auto vals = ex_ins[k]->get_nodal_variable_values(in_step, vars.nodal[v]);
+                std::copy(vals.begin(), vals.end(), local.begin() + offsets[k]);
+            }
+            profile.count("read variables", n_points * sizeof(double));
+            exchange_values(comm, dn, local, owned);
+            ex_out.write_partial_nodal_var(out_step, v + 1, dn.first + 1, owned);
+            profile.count("write variables", 0, owned.size() * sizeof(double));
+        }
+        for (std::size_t v = 0; v < vars.elem.size(); ++v) {
+            // zeros for the inputs that do not have the variable
+            for (auto id : block_ids)
+                elem_vals[id].assign(slice_n[id], 0.);
+            for (std::size_t i = first; i < last; ++i)
+                for (auto & blk : headers[i].blocks) {
+                    if (!truth[0][i - first].at(blk.id)[v])
+                        continue;
+                    auto vals = ex_ins[i - first]->get_elemental_variable_values(
+                        in_step, vars.elem[v], blk.id);
+                    std::copy(vals.begin(),
+                              vals.end(),
+                              elem_vals[blk.id].begin() + local_offset[i][blk.id]);
+                }
+            std::size_t b = 0;
+            for (auto id : block_ids)
+                if (elem_truth[b++ * vars.elem.size() + v])
+                    ex_out.write_partial_elem_var(
+                        out_step, v + 1, id, slice_start[id] + 1, elem_vals[id]);
+        }
+        if (!vars.global.empty()) {
+            std::vector<double> global;
+            if (rank == 0) {
+                auto all = ex_ins[0]->get_global_variable_values(in_step);
+                for (auto idx : vars.global)
+                    global.push_back(all[idx - 1]);
+            }
+            broadcast(comm, global);
+            for (std::size_t v = 0; v < global.size(); ++v)
+                ex_out.write_global_var(out_step, v + 1, global[v]);
+        }
+        bool last_step = t + 1 == steps.size();
+        if (last_step || (opts.sync_every > 0 && (t + 1) % opts.sync_every == 0))
+            ex_out.update();
+        progress.advance(1);
+    }
+}
+
+/// Join input files on all ranks of `comm`, see `join_files_mpi<INT>()`
+///
+/// Inputs are split between ranks in contiguous ranges of about the same number of files.
+void
+join_files_mpi(MPI_Comm comm,
+               const std::vector<std::string> & inputs,
+               const std::string & output,
+               const JoinOptions & opts)
+{
+    int rank = mpi_rank(comm);
+    int n_ranks = mpi_size(comm);
+    if (inputs.size() < static_cast<std::size_t>(n_ranks))
+        throw std::runtime_error(
+            fmt::format("Cannot join {} files on {} ranks", inputs.size(), n_ranks));
+    std::size_t first = inputs.size() * rank / n_ranks;
+    std::size_t last = inputs.size() * (rank + 1) / n_ranks;
+
+    std::vector<ExoHeader> local;
+    {
+        auto timer = profile.scope("read headers");
+        for (std::size_t i = first; i < last; ++i)
+            local.push_back(read_header(inputs[i]));
+    }
+    auto headers = allgather_headers(comm, local);
+    check_variable_names(inputs, headers);
+
+    if (needs_int64(headers))
+        join_files_mpi<int64_t>(comm, inputs, first, last, headers, output, opts);
+    else
+        join_files_mpi<int>(comm, inputs, first, last, headers, output, opts);
+}
+
+#endif
+
+Dedup
+dedup_method(std::string_view str)
+{
+    if (str == "hash")
+        return Dedup::HASH;
+    else if (str == "sort")
+        return Dedup::SORT;
+    else if (str == "external")
+        return Dedup::EXTERNAL;
+    else
+        throw std::runtime_error(fmt::format("Unsupported dedup method {}", str));
+}
+
+/// Parse a size in bytes with an optional `K`, `M` or `G` suffix (powers of 1024)
+std::size_t
+byte_size(const std::string & str)
+{
+    std::size_t pos = 0;
+    unsigned long long n = 0;
+    try {
+        n = std::stoull(str, &pos);
+    }
+    catch (std::exception &) {
+        throw std::runtime_error(fmt::format("Invalid size '{}'", str));
+    }
+    auto suffix = str.substr(pos);
+    if (suffix == "K" || suffix == "k")
+        n <<= 10;
+    else if (suffix == "M" || suffix == "m")
+        n <<= 20;
+    else if (suffix == "G" || suffix == "g")
+        n <<= 30;
+    else if (!suffix.empty())
+        throw std::runtime_error(fmt::format("Invalid size '{}'", str));
+    return n;
 }
 
 int
@@ -345,6 +2285,49 @@ main(int argc, char * argv[])
     options.add_options()
         ("help", "Show this help page")
         ("v,version", "Show the version")
+        ("interface-only", "Match only nodes in regions where input bounding boxes overlap")
+        ("j,jobs", "Number of reader threads", cxxopts::value<unsigned int>()->default_value("1"))
+        ("dedup", "Node deduplication method [hash, sort, external]",
+            cxxopts::value<std::string>()->default_value("hash"))
+        ("tol", "Node matching tolerance (default: 1e-10 times the largest extent of the "
+            "first input)", cxxopts::value<double>())
+        ("mem-limit", "Memory budget of --dedup external, e.g. 512M or 4G",
+            cxxopts::value<std::string>()->default_value("1G"))
+        ("scratch", "Directory for temporary files of --dedup external (default: system temp "
+            "directory)", cxxopts::value<std::string>())
+        ("reorder", "Renumber output nodes and elements [none, hilbert, morton, rcm]",
+            cxxopts::value<std::string>()->default_value("none"))
+        ("compress", "Compress output (netCDF-4) [none, zlib, zstd]",
+            cxxopts::value<std::string>()->default_value("none"))
+        ("level", "Compression level", cxxopts::value<int>()->default_value("1"))
+        ("write-buffers", "Number of time steps buffered for writing",
+            cxxopts::value<unsigned int>()->default_value("2"))
+        ("sync-every", "Flush output to disk every N time steps (0 = only at the end)",
+            cxxopts::value<unsigned int>()->default_value("1"))
+        ("append", "Append new time steps to the output if it exists, otherwise join and save "
+            "the node numbering for later appends")
+        ("map-cache", "Directory to cache node numbering in, so that joins of the same mesh "
+            "skip node matching", cxxopts::value<std::string>())
+        ("mmap", "Read coordinates, connectivity and nodal variables of netCDF-3 inputs straight "
+            "from a memory map of the file")
+        ("times", "Time steps to join [all, first, last, stride:N, range:A:B, N], comma-separated",
+            cxxopts::value<std::string>()->default_value("all"))
+        ("segments", "Inputs are N consecutive runs (e.g. restarts) of the same decomposed mesh, "
+            "given one after another; their time steps are concatenated",
+            cxxopts::value<std::size_t>()->default_value("1"))
+        ("vars", "Comma-separated names of variables to join (default: all)",
+            cxxopts::value<std::vector<std::string>>())
+        ("profile", "Print phase timings to stderr [table, json]",
+            cxxopts::value<std::string>()->implicit_value("table"))
+        ("progress", "Report progress of the phases on stderr [auto, bar, json]; auto draws a bar "
+            "on terminals and prints JSON lines otherwise",
+            cxxopts::value<std::string>()->implicit_value("auto"))
+        ("progress-interval", "Seconds between progress reports",
+            cxxopts::value<double>()->default_value("1"))
+#ifdef EXODUSII_UTILS_MPI
+        ("mpi", "Join on all ranks of MPI_COMM_WORLD (run under mpirun), nodes are matched as with "
+            "--dedup sort")
+#endif
         ("files", "files", cxxopts::value<std::vector<std::string>>())
     ;
     options.parse_positional({ "files" });
@@ -362,7 +2345,69 @@ main(int argc, char * argv[])
             auto inputs = result["files"].as<std::vector<std::string>>();
             auto output = inputs.back();
             inputs.pop_back();
-            join_files(inputs, output);
+            JoinOptions opts;
+            opts.interface_only = result.count("interface-only") > 0;
+            opts.n_jobs = result["jobs"].as<unsigned int>();
+            opts.dedup = dedup_method(result["dedup"].as<std::string>());
+            opts.reorder = reorder_method(result["reorder"].as<std::string>());
+            opts.compression = compression_method(result["compress"].as<std::string>());
+            opts.compression_level = result["level"].as<int>();
+            opts.write_buffers = result["write-buffers"].as<unsigned int>();
+            opts.sync_every = result["sync-every"].as<unsigned int>();
+            opts.times = time_selection(result["times"].as<std::string>());
+            opts.segments = result["segments"].as<std::size_t>();
+            opts.append = result.count("append") > 0;
+            opts.mmap = result.count("mmap") > 0;
+            if (result.count("map-cache"))
+                opts.map_cache = result["map-cache"].as<std::string>();
+            if (result.count("vars"))
+                opts.vars = result["vars"].as<std::vector<std::string>>();
+            opts.mem_limit = byte_size(result["mem-limit"].as<std::string>());
+            if (result.count("tol")) {
+                opts.tol = result["tol"].as<double>();
+                if (!(opts.tol > 0))
+                    throw std::runtime_error("--tol must be positive");
+            }
+            opts.scratch_dir = result.count("scratch")
+                                   ? result["scratch"].as<std::string>()
+                                   : std::filesystem::temp_directory_path().string();
+            if (opts.dedup != Dedup::HASH && opts.interface_only)
+                throw std::runtime_error(
+                    "--interface-only can only be combined with --dedup hash");
+            auto prof_format = ProfileFormat::TABLE;
+            if (result.count("profile")) {
+                prof_format = profile_format(result["profile"].as<std::string>());
+                profile.enable();
+            }
+            auto prog_format = ProgressFormat::BAR;
+            if (result.count("progress"))
+                prog_format = progress_format(result["progress"].as<std::string>());
+            auto prog_interval = result["progress-interval"].as<double>();
+#ifdef EXODUSII_UTILS_MPI
+            if (result.count("mpi")) {
+                if (opts.append || !opts.map_cache.empty() || opts.reorder != Reorder::NONE ||
+                    opts.interface_only || opts.compression != Compression::NONE ||
+                    opts.segments != 1)
+                    throw std::runtime_error("--mpi cannot be combined with --append, "
+                                             "--map-cache, --reorder, --interface-only, "
+                                             "--compress or --segments");
+                int provided;
+                MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+                if (result.count("progress") && mpi_rank(MPI_COMM_WORLD) == 0)
+                    progress.enable(prog_format, prog_interval);
+                join_files_mpi(MPI_COMM_WORLD, inputs, output, opts);
+                progress.finish();
+                if (mpi_rank(MPI_COMM_WORLD) == 0)
+                    profile.report(prof_format, stderr);
+                MPI_Finalize();
+                return 0;
+            }
+#endif
+            if (result.count("progress"))
+                progress.enable(prog_format, prog_interval);
+            join_files(inputs, output, opts);
+            progress.finish();
+            profile.report(prof_format, stderr);
         }
 
         else
@@ -376,7 +2421,16 @@ main(int argc, char * argv[])
         return 1;
     }
     catch (std::exception & e) {
+        // ends the line of a progress bar
+        progress.finish();
         fmt::print(stderr, "Error: {}\n", e.what());
+#ifdef EXODUSII_UTILS_MPI
+        // other ranks may be waiting for this one in a collective call
+        int initialized = 0;
+        MPI_Initialized(&initialized);
+        if (initialized)
+            MPI_Abort(MPI_COMM_WORLD, 1);
+#endif
         return 1;
     }
 }
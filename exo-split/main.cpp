@@ -0,0 +1,704 @@
+// SPDX-FileCopyrightText: 2025 (c) David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#include <cstdlib>
+#include "common.h"
+#include "element_traits.h"
+#include "exo_header.h"
+#include "exo_writer.h"
+#include "io_lock.h"
+#include "partition.h"
+#include "profile.h"
+#include "progress.h"
+#include "reorder.h"
+#include "thread_pool.h"
+#include "time_selection.h"
+#include "cxxopts/cxxopts.hpp"
+#include <sys/resource.h>
+#include <exodusII.h>
+#include <fmt/core.h>
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/// Open files kept back for the input, the standard streams and the libraries
+constexpr std::size_t RESERVED_FILES = 64;
+
+/// Options controlling the split
+struct SplitOptions {
+    /// Number of parts
+    int n_parts = 1;
+    /// Partitioning method
+    PartitionMethod method = PartitionMethod::RCB;
+    /// Number of worker threads
+    unsigned int n_jobs = 1;
+    /// Output compression
+    Compression compression = Compression::NONE;
+    int compression_level = 1;
+    /// Time steps to split
+    TimeSelection times;
+};
+
+/// Mesh of the input file
+template <typename INT>
+struct Mesh {
+    std::vector<double> x, y, z;
+    /// Block index -> connectivity (1-based)
+    std::vector<std::vector<INT>> connect;
+    /// Block index -> element type
+    std::vector<ElementType> element_type;
+    /// Node set index -> node IDs (1-based)
+    std::vector<std::vector<INT>> node_sets;
+    /// Side set index -> element IDs (1-based, file-wide) and sides
+    std::vector<std::vector<INT>> side_set_elems, side_set_sides;
+    std::vector<double> times;
+    /// `truth[b * n_elem_vars + v]` is non-zero if element variable `v` exists on block `b`
+    std::vector<int> truth;
+};
+
+/// One part of the split mesh
+template <typename INT>
+struct Part {
+    /// Nodes of the input (0-based) in the part, ascending
+    std::vector<INT> nodes;
+    /// Block index -> elements of the input block (0-based) in the part, ascending
+    std::vector<std::vector<INT>> elems;
+    /// Block index -> connectivity in the part's node numbering (1-based)
+    std::vector<std::vector<INT>> connect;
+    /// Node set index -> node IDs of the part (1-based)
+    std::vector<std::vector<INT>> node_sets;
+    /// Side set index -> element IDs of the part (1-based, file-wide) and sides
+    std::vector<std::vector<INT>> side_set_elems, side_set_sides;
+};
+
+/// Name of one part of the output
+///
+/// Parts are numbered with as many digits as the number of parts has, like the decomposed files
+/// of parallel codes: `<prefix>.<n_parts>.<part>`
+std::string
+part_filename(const std::string & prefix, int n_parts, int part)
+{
+    auto width = fmt::format("{}", n_parts).size();
+    return fmt::format("{}.{}.{:0{}}", prefix, n_parts, part, width);
+}
+
+/// Raise the limit on open files as far as the system allows
+///
+/// @return Number of files that can be open at the same time
+std::size_t
+raise_open_file_limit()
+{
+    rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) != 0)
+        return 256;
+    if (rl.rlim_cur < rl.rlim_max) {
+        auto raised = rl;
+        // an unlimited maximum is usually refused, so ask only for a lot
+        raised.rlim_cur = rl.rlim_max == RLIM_INFINITY ? 1 << 20 : rl.rlim_max;
+        if (setrlimit(RLIMIT_NOFILE, &raised) == 0)
+            rl = raised;
+    }
+    return rl.rlim_cur == RLIM_INFINITY ? 1 << 20 : rl.rlim_cur;
+}
+
+/// Read the mesh of the input file
+///
+/// @param filename Input file name
+/// @param hdr Header of the input file
+template <typename INT>
+Mesh<INT>
+read_mesh(const std::string & filename, const ExoHeader & hdr)
+{
+    if (hdr.dim != 2 && hdr.dim != 3)
+        throw std::runtime_error(fmt::format("Unsupported dimension {}", hdr.dim));
+
+    Mesh<INT> mesh;
+    for (auto & blk : hdr.blocks) {
+        auto et = element_type(blk.element_type);
+        if (blk.n_nodes_per_elem != num_nodes(et))
+            throw std::runtime_error(
+                fmt::format("Block {} has {} nodes per element, {} elements have {}",
+                            blk.id,
+                            blk.n_nodes_per_elem,
+                            blk.element_type,
+                            num_nodes(et)));
+        mesh.element_type.push_back(et);
+    }
+
+    auto lock = lock_io();
+    detail::ExoHandle exo(filename);
+    ex_set_int64_status(exo.exoid, sizeof(INT) == 8 ? EX_BULK_INT64_API : 0);
+
+    mesh.x.resize(hdr.n_nodes);
+    mesh.y.resize(hdr.n_nodes);
+    mesh.z.assign(hdr.n_nodes, 0.);
+    if (hdr.n_nodes > 0)
+        detail::check_ex(ex_get_coord(exo.exoid,
+                                      mesh.x.data(),
+                                      mesh.y.data(),
+                                      hdr.dim == 3 ? mesh.z.data() : nullptr),
+                         "ex_get_coord");
+
+    for (auto & blk : hdr.blocks) {
+        auto & connect = mesh.connect.emplace_back(blk.n_elems * blk.n_nodes_per_elem);
+        if (blk.n_elems > 0)
+            detail::check_ex(
+                ex_get_conn(exo.exoid, EX_ELEM_BLOCK, blk.id, connect.data(), nullptr, nullptr),
+                "ex_get_conn");
+    }
+
+    for (auto & ns : hdr.node_sets) {
+        auto & ids = mesh.node_sets.emplace_back(ns.size);
+        if (ns.size > 0)
+            detail::check_ex(ex_get_set(exo.exoid, EX_NODE_SET, ns.id, ids.data(), nullptr),
+                             "ex_get_set");
+    }
+    for (auto & ss : hdr.side_sets) {
+        auto & elems = mesh.side_set_elems.emplace_back(ss.size);
+        auto & sides = mesh.side_set_sides.emplace_back(ss.size);
+        if (ss.size > 0)
+            detail::check_ex(
+                ex_get_set(exo.exoid, EX_SIDE_SET, ss.id, elems.data(), sides.data()),
+                "ex_get_set");
+    }
+
+    mesh.times.resize(hdr.n_times);
+    if (hdr.n_times > 0)
+        detail::check_ex(ex_get_all_times(exo.exoid, mesh.times.data()), "ex_get_all_times");
+    mesh.truth = read_truth_table(exo.exoid, hdr);
+    return mesh;
+}
+
+/// Centroids of all elements, in file order
+template <typename INT>
+void
+element_centroids(const Mesh<INT> & mesh,
+                  std::vector<double> & cx,
+                  std::vector<double> & cy,
+                  std::vector<double> & cz)
+{
+    cx.clear();
+    cy.clear();
+    cz.clear();
+    std::vector<double> bx, by, bz;
+    for (std::size_t b = 0; b < mesh.connect.size(); ++b) {
+        dispatch(mesh.element_type[b], [&](auto traits) {
+            detail::element_centroids<decltype(traits)::N_NODES>(
+                mesh.connect[b], mesh.x, mesh.y, mesh.z, bx, by, bz);
+        });
+        cx.insert(cx.end(), bx.begin(), bx.end());
+        cy.insert(cy.end(), by.begin(), by.end());
+        cz.insert(cz.end(), bz.begin(), bz.end());
+    }
+}
+
+/// Local connectivity of the elements of a block that are in a part
+///
+/// @tparam NN Number of nodes per element
+/// @param connect Connectivity of the input block (1-based)
+/// @param elems Elements of the block in the part
+/// @param local Input node (0-based) -> node of the part (1-based)
+/// @param part_connect Connectivity in the part's numbering (1-based)
+template <int NN, typename INT>
+void
+localize_block(const std::vector<INT> & connect,
+               const std::vector<INT> & elems,
+               const std::vector<INT> & local,
+               std::vector<INT> & part_connect)
+{
+    part_connect.resize(elems.size() * NN);
+    for (std::size_t k = 0; k < elems.size(); ++k) {
+        const INT * src = connect.data() + static_cast<std::size_t>(elems[k]) * NN;
+        INT * dest = part_connect.data() + k * NN;
+        for (int j = 0; j < NN; ++j)
+            dest[j] = local[src[j] - 1];
+    }
+}
+
+/// Build the parts of the mesh
+///
+/// Every element goes to the part it was assigned to, every part gets the nodes its elements use,
+/// so nodes on part boundaries are in several parts. Nodes and elements keep their input order
+/// within a part, and every part has all blocks and sets of the input (possibly empty).
+///
+/// @param pool Thread pool
+/// @param hdr Header of the input file
+/// @param mesh Mesh of the input file
+/// @param elem_part Part of every element, in file order
+/// @param n_parts Number of parts
+template <typename INT>
+std::vector<Part<INT>>
+build_parts(ThreadPool & pool,
+            const ExoHeader & hdr,
+            const Mesh<INT> & mesh,
+            const std::vector<int> & elem_part,
+            int n_parts)
+{
+    auto n_blocks = hdr.blocks.size();
+    std::vector<Part<INT>> parts(n_parts);
+    for (auto & part : parts) {
+        part.elems.resize(n_blocks);
+        part.connect.resize(n_blocks);
+        part.node_sets.resize(hdr.node_sets.size());
+        part.side_set_elems.resize(hdr.side_sets.size());
+        part.side_set_sides.resize(hdr.side_sets.size());
+    }
+
+    // position of every element within its block of its part
+    std::vector<INT> elem_pos(elem_part.size());
+    for (std::size_t b = 0, e = 0; b < n_blocks; ++b)
+        for (int64_t i = 0; i < hdr.blocks[b].n_elems; ++i, ++e) {
+            auto & elems = parts[elem_part[e]].elems[b];
+            elem_pos[e] = elems.size();
+            elems.push_back(i);
+        }
+
+    parallel_for(pool, parts.size(), [&](std::size_t p_begin, std::size_t p_end) {
+        // input node -> node of the current part (1-based), 0 if not in the part
+        std::vector<INT> local(hdr.n_nodes, 0);
+        for (auto p = p_begin; p < p_end; ++p) {
+            auto & part = parts[p];
+            for (std::size_t b = 0; b < n_blocks; ++b) {
+                auto nn = hdr.blocks[b].n_nodes_per_elem;
+                for (auto i : part.elems[b])
+                    for (int64_t j = 0; j < nn; ++j) {
+                        auto n = mesh.connect[b][i * nn + j] - 1;
+                        if (local[n] == 0) {
+                            local[n] = 1;
+                            part.nodes.push_back(n);
+                        }
+                    }
+            }
+            std::sort(part.nodes.begin(), part.nodes.end());
+            for (std::size_t k = 0; k < part.nodes.size(); ++k)
+                local[part.nodes[k]] = k + 1;
+            for (std::size_t b = 0; b < n_blocks; ++b)
+                dispatch(mesh.element_type[b], [&](auto traits) {
+                    localize_block<decltype(traits)::N_NODES>(
+                        mesh.connect[b], part.elems[b], local, part.connect[b]);
+                });
+            for (auto n : part.nodes)
+                local[n] = 0;
+            progress.advance(1);
+        }
+    });
+
+    if (!hdr.node_sets.empty()) {
+        // input node -> the parts it is in and its ID there (1-based)
+        std::vector<std::size_t> first(hdr.n_nodes + 1, 0);
+        for (auto & part : parts)
+            for (auto n : part.nodes)
+                first[n + 1]++;
+        for (int64_t n = 0; n < hdr.n_nodes; ++n)
+            first[n + 1] += first[n];
+        std::vector<std::pair<int, INT>> copies(first.back());
+        auto fill = first;
+        for (int p = 0; p < n_parts; ++p)
+            for (std::size_t k = 0; k < parts[p].nodes.size(); ++k)
+                copies[fill[parts[p].nodes[k]]++] = { p, static_cast<INT>(k + 1) };
+
+        for (std::size_t s = 0; s < hdr.node_sets.size(); ++s)
+            for (auto id : mesh.node_sets[s])
+                for (auto c = first[id - 1]; c < first[id]; ++c)
+                    parts[copies[c].first].node_sets[s].push_back(copies[c].second);
+    }
+
+    if (!hdr.side_sets.empty()) {
+        // part -> block index -> file-wide ID of the block's first element minus one
+        std::vector<std::vector<int64_t>> block_offset(n_parts, std::vector<int64_t>(n_blocks));
+        for (int p = 0; p < n_parts; ++p)
+            for (std::size_t b = 1; b < n_blocks; ++b)
+                block_offset[p][b] = block_offset[p][b - 1] + parts[p].elems[b - 1].size();
+        std::map<int64_t, std::size_t> block_index;
+        for (std::size_t b = 0; b < n_blocks; ++b)
+            block_index[hdr.blocks[b].id] = b;
+
+        ElementLocator locator(hdr);
+        for (std::size_t s = 0; s < hdr.side_sets.size(); ++s) {
+            auto & elems = mesh.side_set_elems[s];
+            auto & sides = mesh.side_set_sides[s];
+            for (std::size_t k = 0; k < elems.size(); ++k) {
+                int64_t e = elems[k] - 1;
+                auto p = elem_part[e];
+                auto b = block_index.at(locator.locate(e).first);
+                parts[p].side_set_elems[s].push_back(block_offset[p][b] + elem_pos[e] + 1);
+                parts[p].side_set_sides[s].push_back(sides[k]);
+            }
+        }
+    }
+    return parts;
+}
+
+/// Write the mesh of a part and define its variables
+///
+/// @param exo Output file
+/// @param hdr Header of the input file
+/// @param mesh Mesh of the input file
+/// @param part The part
+template <typename INT>
+void
+write_part_mesh(ExoWriter & exo,
+                const ExoHeader & hdr,
+                const Mesh<INT> & mesh,
+                const Part<INT> & part)
+{
+    auto n = part.nodes.size();
+    std::vector<double> x(n), y(n), z(hdr.dim == 3 ? n : 0);
+    std::vector<INT> node_ids(n);
+    for (std::size_t k = 0; k < n; ++k) {
+        auto i = part.nodes[k];
+        x[k] = mesh.x[i];
+        y[k] = mesh.y[i];
+        if (hdr.dim == 3)
+            z[k] = mesh.z[i];
+        node_ids[k] = i + 1;
+    }
+    std::vector<INT> elem_ids;
+    int64_t first_elem = 0;
+    for (std::size_t b = 0; b < hdr.blocks.size(); ++b) {
+        for (auto i : part.elems[b])
+            elem_ids.push_back(first_elem + i + 1);
+        first_elem += hdr.blocks[b].n_elems;
+    }
+
+    auto lock = lock_io();
+    exo.init(hdr.title.c_str(),
+             hdr.dim,
+             n,
+             elem_ids.size(),
+             hdr.blocks.size(),
+             hdr.node_sets.size(),
+             hdr.side_sets.size());
+    if (hdr.dim == 3)
+        exo.write_coords(x, y, z);
+    else
+        exo.write_coords(x, y);
+    exo.write_node_id_map(node_ids);
+    for (std::size_t b = 0; b < hdr.blocks.size(); ++b)
+        exo.write_block(hdr.blocks[b].id,
+                        exodus_element_name(mesh.element_type[b]),
+                        part.elems[b].size(),
+                        part.connect[b]);
+    exo.write_elem_id_map(elem_ids);
+    for (std::size_t s = 0; s < hdr.node_sets.size(); ++s)
+        exo.write_node_set(hdr.node_sets[s].id, part.node_sets[s]);
+    for (std::size_t s = 0; s < hdr.side_sets.size(); ++s)
+        exo.write_side_set(hdr.side_sets[s].id, part.side_set_elems[s], part.side_set_sides[s]);
+
+    if (!hdr.nodal_var_names.empty())
+        exo.write_nodal_var_names(hdr.nodal_var_names);
+    if (!hdr.elem_var_names.empty()) {
+        exo.write_elem_var_names(hdr.elem_var_names);
+        exo.write_elem_truth_table(hdr.blocks.size(), hdr.elem_var_names.size(), mesh.truth);
+    }
+    if (!hdr.global_var_names.empty())
+        exo.write_global_var_names(hdr.global_var_names);
+}
+
+/// Variable values of the input at one time step
+struct StepValues {
+    /// Nodal variable -> values
+    std::vector<std::vector<double>> nodal;
+    /// Block index -> element variable -> values (empty if the variable is not on the block)
+    std::vector<std::vector<std::vector<double>>> elem;
+    /// Global variable values
+    std::vector<double> global;
+};
+
+/// Read all variables of one time step of the input
+template <typename INT>
+void
+read_step(int exoid, const ExoHeader & hdr, const Mesh<INT> & mesh, int step, StepValues & vals)
+{
+    auto n_elem_vars = hdr.elem_var_names.size();
+    uint64_t bytes = 0;
+    auto lock = lock_io();
+    vals.nodal.resize(hdr.nodal_var_names.size());
+    for (std::size_t v = 0; v < vals.nodal.size(); ++v) {
+        vals.nodal[v].resize(hdr.n_nodes);
+        detail::check_ex(
+            ex_get_var(exoid, step, EX_NODAL, v + 1, 1, hdr.n_nodes, vals.nodal[v].data()),
+            "ex_get_var");
+        bytes += hdr.n_nodes * sizeof(double);
+    }
+    vals.elem.resize(hdr.blocks.size());
+    for (std::size_t b = 0; b < hdr.blocks.size(); ++b) {
+        auto & blk = hdr.blocks[b];
+        vals.elem[b].resize(n_elem_vars);
+        for (std::size_t v = 0; v < n_elem_vars; ++v) {
+            if (!mesh.truth[b * n_elem_vars + v] || blk.n_elems == 0)
+                continue;
+            vals.elem[b][v].resize(blk.n_elems);
+            detail::check_ex(ex_get_var(exoid,
+                                        step,
+                                        EX_ELEM_BLOCK,
+                                        v + 1,
+                                        blk.id,
+                                        blk.n_elems,
+                                        vals.elem[b][v].data()),
+                             "ex_get_var");
+            bytes += blk.n_elems * sizeof(double);
+        }
+    }
+    vals.global.resize(hdr.global_var_names.size());
+    if (!vals.global.empty())
+        detail::check_ex(
+            ex_get_var(exoid, step, EX_GLOBAL, 1, 1, vals.global.size(), vals.global.data()),
+            "ex_get_var");
+    profile.count("read variables", bytes + vals.global.size() * sizeof(double));
+    progress.advance(0, bytes + vals.global.size() * sizeof(double));
+}
+
+/// Write the slice of one time step that belongs to a part
+///
+/// @param exo Output file of the part
+/// @param hdr Header of the input file
+/// @param part The part
+/// @param step Output time step (1-based)
+/// @param time Time
+/// @param vals Values of the input
+template <typename INT>
+void
+write_part_step(ExoWriter & exo,
+                const ExoHeader & hdr,
+                const Part<INT> & part,
+                int step,
+                double time,
+                const StepValues & vals)
+{
+    std::vector<std::vector<double>> nodal(vals.nodal.size());
+    uint64_t bytes = 0;
+    for (std::size_t v = 0; v < nodal.size(); ++v) {
+        nodal[v].resize(part.nodes.size());
+        for (std::size_t k = 0; k < part.nodes.size(); ++k)
+            nodal[v][k] = vals.nodal[v][part.nodes[k]];
+        bytes += nodal[v].size() * sizeof(double);
+    }
+    std::vector<std::vector<std::vector<double>>> elem(vals.elem.size());
+    for (std::size_t b = 0; b < elem.size(); ++b) {
+        elem[b].resize(vals.elem[b].size());
+        if (part.elems[b].empty())
+            continue;
+        for (std::size_t v = 0; v < elem[b].size(); ++v) {
+            if (vals.elem[b][v].empty())
+                continue;
+            elem[b][v].resize(part.elems[b].size());
+            for (std::size_t k = 0; k < part.elems[b].size(); ++k)
+                elem[b][v][k] = vals.elem[b][v][part.elems[b][k]];
+            bytes += elem[b][v].size() * sizeof(double);
+        }
+    }
+    profile.count("write variables", 0, bytes + vals.global.size() * sizeof(double));
+    progress.advance(0, bytes + vals.global.size() * sizeof(double));
+
+    auto lock = lock_io();
+    exo.write_time(step, time);
+    for (std::size_t v = 0; v < nodal.size(); ++v)
+        exo.write_nodal_var(step, v + 1, nodal[v]);
+    for (std::size_t b = 0; b < elem.size(); ++b)
+        for (std::size_t v = 0; v < elem[b].size(); ++v)
+            if (!elem[b][v].empty())
+                exo.write_elem_var(step, v + 1, hdr.blocks[b].id, elem[b][v]);
+    for (std::size_t v = 0; v < vals.global.size(); ++v)
+        exo.write_global_var(step, v + 1, vals.global[v]);
+}
+
+/// Split a file into parts
+///
+/// All parts of a batch are open at once, so the input variables are read in one pass over the
+/// time steps and every value is sliced into all parts of the batch. Batches are only needed when
+/// there are more parts than files the process may open.
+///
+/// @param input Input file name
+/// @param prefix Prefix of the output file names
+/// @param hdr Header of the input file
+/// @param opts Split options
+template <typename INT>
+void
+split_file(const std::string & input,
+           const std::string & prefix,
+           const ExoHeader & hdr,
+           const SplitOptions & opts)
+{
+    if (opts.n_parts > hdr.n_elems)
+        throw std::runtime_error(
+            fmt::format("Cannot split {} elements into {} parts", hdr.n_elems, opts.n_parts));
+
+    ThreadPool pool(opts.n_jobs);
+    Mesh<INT> mesh;
+    {
+        auto timer = profile.scope("read mesh");
+        progress.phase("read mesh", hdr.n_nodes, "nodes");
+        mesh = read_mesh<INT>(input, hdr);
+        uint64_t bytes = hdr.n_nodes * hdr.dim * sizeof(double);
+        for (auto & connect : mesh.connect)
+            bytes += connect.size() * sizeof(INT);
+        profile.count("read mesh", bytes);
+        progress.advance(hdr.n_nodes, bytes);
+    }
+
+    std::vector<int> elem_part;
+    {
+        auto timer = profile.scope("partition");
+        progress.phase("partition", hdr.n_elems, "elems");
+        std::vector<double> cx, cy, cz;
+        element_centroids(mesh, cx, cy, cz);
+        elem_part = partition(pool, opts.method, cx, cy, cz, opts.n_parts);
+        profile.count("partition", 0, 0, elem_part.size(), "elems");
+        progress.advance(elem_part.size());
+    }
+
+    std::vector<Part<INT>> parts;
+    {
+        auto timer = profile.scope("build parts");
+        progress.phase("build parts", opts.n_parts, "parts");
+        parts = build_parts(pool, hdr, mesh, elem_part, opts.n_parts);
+    }
+
+    auto steps = opts.times.steps(hdr.n_times);
+    auto n_files = raise_open_file_limit();
+    std::size_t batch = n_files > RESERVED_FILES ? n_files - RESERVED_FILES : 1;
+
+    auto lock = lock_io();
+    detail::ExoHandle exo(input);
+    lock.unlock();
+    for (std::size_t first = 0; first < parts.size(); first += batch) {
+        auto n = std::min(batch, parts.size() - first);
+        std::vector<std::unique_ptr<ExoWriter>> writers(n);
+        {
+            auto timer = profile.scope("write mesh");
+            progress.phase("write mesh", n, "parts");
+            parallel_for(pool, n, [&](std::size_t begin, std::size_t end) {
+                for (auto i = begin; i < end; ++i) {
+                    auto filename = part_filename(prefix, opts.n_parts, first + i);
+                    {
+                        auto lock = lock_io();
+                        writers[i] = std::make_unique<ExoWriter>(
+                            filename, hdr.int64, opts.compression, opts.compression_level);
+                    }
+                    write_part_mesh(*writers[i], hdr, mesh, parts[first + i]);
+                    progress.advance(1);
+                }
+            });
+        }
+
+        progress.phase("variables", steps.size(), "steps");
+        StepValues vals;
+        for (std::size_t k = 0; k < steps.size(); ++k) {
+            {
+                auto timer = profile.scope("read variables");
+                read_step(exo.exoid, hdr, mesh, steps[k], vals);
+            }
+            auto timer = profile.scope("write variables");
+            auto time = mesh.times[steps[k] - 1];
+            parallel_for(pool, n, [&](std::size_t begin, std::size_t end) {
+                for (auto i = begin; i < end; ++i)
+                    write_part_step(*writers[i], hdr, parts[first + i], k + 1, time, vals);
+            });
+            progress.advance(1);
+        }
+
+        auto timer = profile.scope("close");
+        lock.lock();
+        writers.clear();
+        lock.unlock();
+    }
+    // the input is closed under the lock
+    lock.lock();
+}
+
+int
+main(int argc, char * argv[])
+{
+    cxxopts::Options options("exo-split", "Split an exodusII file into parts");
+
+    // clang-format off
+    options.add_options()
+        ("help", "Show this help page")
+        ("v,version", "Show the version")
+        ("n,parts", "Number of parts", cxxopts::value<int>())
+        ("method", "Partitioning method [rcb, hilbert, morton]",
+            cxxopts::value<std::string>()->default_value("rcb"))
+        ("j,jobs", "Number of worker threads",
+            cxxopts::value<unsigned int>()->default_value("1"))
+        ("o,output", "Prefix of the output files, parts are named <prefix>.<parts>.<part> "
+            "(default: the input file name)", cxxopts::value<std::string>())
+        ("compress", "Compress output (netCDF-4) [none, zlib, zstd]",
+            cxxopts::value<std::string>()->default_value("none"))
+        ("level", "Compression level", cxxopts::value<int>()->default_value("1"))
+        ("times", "Time steps to split [all, first, last, stride:N, range:A:B, N], comma-separated",
+            cxxopts::value<std::string>()->default_value("all"))
+        ("profile", "Print phase timings to stderr [table, json]",
+            cxxopts::value<std::string>()->implicit_value("table"))
+        ("progress", "Report progress of the phases on stderr [auto, bar, json]; auto draws a bar "
+            "on terminals and prints JSON lines otherwise",
+            cxxopts::value<std::string>()->implicit_value("auto"))
+        ("progress-interval", "Seconds between progress reports",
+            cxxopts::value<double>()->default_value("1"))
+        ("file", "file", cxxopts::value<std::string>())
+    ;
+    options.parse_positional({ "file" });
+    options.positional_help("<input>");
+    // clang-format on
+
+    cxxopts::ParseResult result;
+    try {
+        result = options.parse(argc, argv);
+
+        if (result.count("version"))
+            fmt::println(stdout, "exo-split version 0.0.0");
+
+        else if (result.count("file") && result.count("parts")) {
+            auto input = result["file"].as<std::string>();
+            auto prefix = result.count("output") ? result["output"].as<std::string>() : input;
+            SplitOptions opts;
+            opts.n_parts = result["parts"].as<int>();
+            if (opts.n_parts < 1)
+                throw std::runtime_error("--parts must be positive");
+            opts.method = partition_method(result["method"].as<std::string>());
+            opts.n_jobs = result["jobs"].as<unsigned int>();
+            opts.compression = compression_method(result["compress"].as<std::string>());
+            opts.compression_level = result["level"].as<int>();
+            opts.times = time_selection(result["times"].as<std::string>());
+            auto prof_format = ProfileFormat::TABLE;
+            if (result.count("profile")) {
+                prof_format = profile_format(result["profile"].as<std::string>());
+                profile.enable();
+            }
+            if (result.count("progress"))
+                progress.enable(progress_format(result["progress"].as<std::string>()),
+                                result["progress-interval"].as<double>());
+
+            ExoHeader hdr;
+            {
+                auto timer = profile.scope("read header");
+                hdr = read_header(input);
+            }
+            if (hdr.int64)
+                split_file<int64_t>(input, prefix, hdr, opts);
+            else
+                split_file<int>(input, prefix, hdr, opts);
+            progress.finish();
+            profile.report(prof_format, stderr);
+        }
+
+        else
+            fmt::print(stdout, "{}", options.help());
+
+        return 0;
+    }
+    catch (const cxxopts::exceptions::exception & e) {
+        fmt::print(stderr, "Error: {}\n", e.what());
+        fmt::print(stdout, "{}", options.help());
+        return 1;
+    }
+    catch (std::exception & e) {
+        // ends the line of a progress bar
+        progress.finish();
+        fmt::print(stderr, "Error: {}\n", e.what());
+        return 1;
+    }
+}